@@ -68,5 +68,98 @@
 
 // definitions for ADC
 #define ADC_CHANNEL		4			/**< ADC channel (PC4)							*/
+#define ADC_SAMPLE_RATE	200			/**< scan rate in Hz (Timer1 triggered ADC)		*/
+
+/**
+* scan list of the ADC: {channel, reference, extra bits (4^n conversions), discarded conversions}
+* values are transmitted as field1...fieldN in the order of this list.
+*/
+#define ADC_SCAN_CHANNELS	{ {ADC_CHANNEL, ADC_REF_INTERNAL, 2, 1} }
+
+/**
+* count of channels in the scan list: size of the value arrays. The list itself is
+* only instantiated once (in flash, measureRoutine.c).
+*/
+#define ADC_SCAN_COUNT		(sizeof((const ADC_ScanChannel[])ADC_SCAN_CHANNELS) / sizeof(ADC_ScanChannel))
+
+/**
+* filter chain per channel of the scan list: up to 3 stages {type, parameter}.
+* FILTER_NONE ends the chain, see libs/filter/filter.h for the parameters.
+*/
+#define ADC_FILTER_CHANNELS	{ { {FILTER_MEDIAN, 3}, {FILTER_IIR, 2}, {FILTER_NONE, 0} } }
+
+// transmit mean, min, max and standard deviation of every send interval
+// instead of a single value (4 fields per channel)
+#define MEASURE_STATISTICS
+
+// send on change: transmit only if a value leaves the deadband around the
+// last transmitted value (0 disables the deadband, every interval is sent);
+// the statistics of suppressed intervals are part of the next transmission
+#define REPORT_DEADBAND_ABS		0		/**< absolute deadband in ADC counts			*/
+#define REPORT_DEADBAND_REL		0		/**< relative deadband in percent				*/
+#define REPORT_HEARTBEAT		900		/**< max. seconds without transmission			*/
+
+// send schedule: handling of send slots missed during a long upload
+// (RUN_SKIP or RUN_CATCHUP, see runRoutine.h)
+#define RUN_MISSED_SLOTS		RUN_SKIP
+#define RUN_MAX_CATCHUP			3		/**< max. missed slots sent with RUN_CATCHUP			*/
+
+// keep the TCP connection to the target open between the uploads
+// (comment out to open a new connection for every upload)
+#define HTTP_KEEPALIVE
+
+// output of the values: CONFIG_OUTPUT_HTTP (requests to the hostname), CONFIG_OUTPUT_UDP
+// (one datagram per send slot to IP:Port of the configuration, no TCP connection) or
+// CONFIG_OUTPUT_MQTT (QoS 0 publish to the broker at IP:Port over one persistent connection)
+// a fifth parameter in config.txt (http|udp|mqtt) overrides the default
+#define OUTPUT_DEFAULT			CONFIG_OUTPUT_HTTP
+#define UDP_FORMAT				TELEMETRY_INFLUX	/**< TELEMETRY_INFLUX or TELEMETRY_STATSD	*/
+#define UDP_MEASUREMENT			"datalogger"		/**< measurement name / metric prefix		*/
+#define MQTT_CLIENT_ID			"datalogger-1"		/**< client identifier (unique at the broker)	*/
+#define MQTT_TOPIC				"datalogger"		/**< topics: MQTT_TOPIC/ch1, MQTT_TOPIC/ch2...	*/
+#define MQTT_KEEPALIVE			120					/**< keep alive in s (> 2 * send interval)		*/
+
+// batched upload: collect the values of up to BATCH_SIZE send slots (one packet) and upload them
+// with one POST (thingspeak bulk-update, one field per channel)
+// BATCH_URL has to name the own thingspeak channel (replace CHANNEL_ID by its number),
+// it is also the target of the spool drain with HTTP output
+// (comment out to send every slot with a GET request)
+//#define HTTP_BATCH
+#define BATCH_URL				"/channels/CHANNEL_ID/bulk_update.csv"	/**< bulk-update target	*/
+#define BATCH_API_KEY			"H68PLC982WAV"						/**< write api key			*/
+
+// store-and-forward: samples which could not be sent are kept on the SDcard and sent
+// later, oldest first. SPOOL_FILE has to exist in the root directory and be contiguous,
+// eg. "dd if=/dev/zero of=SPOOL.BIN bs=1k count=1024" on a freshly formatted card;
+// the file size defines the capacity (36 samples per 512 byte sector)
+// with HTTP output the spool is sent to BATCH_URL, configure it before enabling the spool
+// (uncomment to enable)
+//#define SD_SPOOL
+#define SPOOL_FILE				"spool.bin"
+#define SPOOL_DRAIN_COUNT		4		/**< max. samples sent per drain				*/
+#define SPOOL_DRAIN_PERIOD		5000	/**< min. time between two drains in ms			*/
+#define SPOOL_DRAIN_MARGIN		3		/**< min. seconds left until the next send slot	*/
+
+// local log: the values of the scan list are appended as CSV lines to LOG_FILE on the
+// SDcard while the datalogger runs, the file is created if needed (comment out to disable)
+#define SD_LOG
+#define LOG_FILE				"log.csv"
+#define LOG_PERIOD				1000	/**< ms between two lines								*/
+#define LOG_BUFFER_SIZE			128		/**< lines collected in RAM before a write (bytes)		*/
+#define LOG_SYNC_COUNT			60		/**< lines between two updates of the file size			*/
+
+// triggered capture: upload a burst of samples around a transient immediately
+// (HTTP POST to CAPTURE_URL on the hostname, only with CONFIG_OUTPUT_HTTP)
+// thingspeak has no such endpoint: the receiver is an own web service, which accepts
+// the form body "pre=<samples before the trigger>&samples=<v1>,<v2>,..." (raw values
+// of CAPTURE_CHANNEL) and answers with HTTP 2xx; every failed upload blocks the loop
+// (uncomment to enable)
+//#define MEASURE_CAPTURE
+#define CAPTURE_CHANNEL			0		/**< index of the channel in ADC_SCAN_CHANNELS			*/
+#define CAPTURE_THRESHOLD		3000	/**< trigger on a rising crossing (0: disabled)			*/
+#define CAPTURE_SLOPE			400		/**< trigger on a step between two samples (0: disabled)	*/
+#define CAPTURE_PRE_SAMPLES		16		/**< samples before the trigger							*/
+#define CAPTURE_POST_SAMPLES	47		/**< samples after the trigger							*/
+#define CAPTURE_URL				"/capture"		/**< target of the burst upload (own receiver)	*/
 
 #endif /* IOCONFIG_H_ */
\ No newline at end of file
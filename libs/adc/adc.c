@@ -29,9 +29,47 @@
  *
  * ADC hardware initialization and implementation of reading values in single 
  * mode and oversampling mode.
+ *
+ * Background acquisition is done by a scan sequencer. A scan converts all channels
+ * of the scan list, every channel with its own reference voltage, oversampling factor
+ * and count of discarded conversions after switching the multiplexer.
+ * Oversampling works as oversample and decimate: 4^n conversions are summed up and
+ * shifted right by n, which results in 10+n bits without any division. The results of
+ * one scan are published as one frame. The ADC complete interrupt writes the frames
+ * into a single-producer/single-consumer ring buffer, the main loop only drains the
+ * frames which are ready.
+ *
+ * In free running mode a new scan starts directly after the previous one.
+ * In timer triggered mode the first conversion of every scan is started by hardware
+ * (auto trigger source Timer0 compare match A or Timer1 compare match B). The sample
+ * timing does not depend on the main loop.
 */
 
 #include "adc.h"
+#include "../timebase/timebase.h"
+
+static ADC_ScanChannel scanList[ADC_SCAN_MAX_CHANNELS];	/**< channels of a scan							*/
+static volatile uint8_t scanCount = 0;					/**< count of channels in the scan list			*/
+static volatile uint8_t scanIndex = 0;					/**< channel of the scan list in conversion		*/
+static volatile uint8_t scanDiscard = 0;				/**< conversions left to discard				*/
+static volatile uint16_t scanConversions = 0;			/**< conversions summed up for the channel		*/
+static volatile uint32_t scanSum = 0;					/**< sum of the conversions of the channel		*/
+static volatile uint8_t scanSequence = 0;				/**< scan counter								*/
+
+static volatile ADC_Frame frameBuffer[ADC_BUFFER_SIZE];	/**< frame ring buffer								*/
+static volatile uint8_t frameHead = 0;					/**< write index (only changed by the ISR)			*/
+static volatile uint8_t frameTail = 0;					/**< read index (only changed by the main loop)		*/
+static volatile uint16_t droppedFrames = 0;				/**< count of frames lost due to a full buffer		*/
+static volatile uint8_t freerunDivider = 0;				/**< scan counter for the frame divider				*/
+static volatile uint8_t triggerSource = ADC_TRIGGER_FREERUN;	/**< active auto trigger source				*/
+static volatile uint16_t triggerPeriod = 0;				/**< Timer1 ticks between two scans					*/
+static volatile uint16_t triggerStamp = 0;				/**< Timer1 value of the last compare match			*/
+
+static volatile ADC_SampleCallback sampleCallback = 0;	/**< callback for every sample of a channel		*/
+static volatile uint8_t sampleIndex = 0;				/**< scan list index of the callback channel		*/
+
+static volatile bool jitterEnabled = false;				/**< trigger-to-read latency measurement active		*/
+static volatile ADC_JitterStat jitter;					/**< trigger-to-read latency statistics				*/
 
 /**
  *
@@ -100,4 +138,558 @@ uint16_t ADC_ReadAvg(uint8_t channel, uint8_t nsamples)
 	}
 	
 	return (uint16_t) (sum / nsamples);
-}
\ No newline at end of file
+}
+
+
+/**
+ *
+ * @brief Get analog value with oversampling and decimation
+ *
+ * Sum up 4^n conversions and shift the sum right by n. Every 4 times oversampling
+ * increases the resolution by one bit. No division is necessary.
+ *
+ * @param channel ADC channel of the uC.
+ *
+ * @param extraBits additional bits of resolution n (0...ADC_MAX_EXTRA_BITS)
+ *
+ * @return digital measure value (0...2^(10+n)-1)
+ *
+*/
+uint16_t ADC_ReadOversampled(uint8_t channel, uint8_t extraBits)
+{
+	uint32_t sum = 0;
+	
+	if(extraBits > ADC_MAX_EXTRA_BITS)
+	extraBits = ADC_MAX_EXTRA_BITS;
+	
+	uint16_t nsamples = (uint16_t)1 << (2 * extraBits);	// 4^n conversions
+	
+	for(uint16_t i = 0; i < nsamples; i++)
+	{
+		sum += ADC_Read(channel);
+	}
+	
+	return (uint16_t) (sum >> extraBits);
+}
+
+
+/**
+ *
+ * @brief Configure the scan list
+ *
+ * The list is copied, at most ADC_SCAN_MAX_CHANNELS channels are used.
+ * Values of channel i of the list are stored in ADC_Frame.value[i].
+ * A channel with n extra bits needs 4^n conversions per scan.
+ *
+ * @note call this function only while background acquisition is stopped.
+ *
+ * @param channels Pointer of the channel configurations
+ * @param count count of channels in the list
+ *
+ * @return void
+ *
+*/
+void ADC_ScanConfigure(const ADC_ScanChannel *channels, uint8_t count)
+{
+	if(count > ADC_SCAN_MAX_CHANNELS)
+	count = ADC_SCAN_MAX_CHANNELS;
+	
+	for(uint8_t i = 0; i < count; i++)
+	{
+		scanList[i] = channels[i];
+		
+		if(scanList[i].extraBits > ADC_MAX_EXTRA_BITS)
+		scanList[i].extraBits = ADC_MAX_EXTRA_BITS;
+	}
+	
+	scanCount = count;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Count of channels in the scan list
+ *
+ * @return count of valid values in a frame
+ *
+*/
+uint8_t ADC_GetScanChannelCount(void)
+{
+	return scanCount;
+}
+
+
+/**
+ *
+ * @brief Select a channel of the scan list
+ *
+ * Set reference voltage and multiplexer and reset the oversampling state.
+ *
+ * @param index position in the scan list
+ *
+ * @return void
+ *
+*/
+static inline void ADC_ScanSelect(uint8_t index)
+{
+	scanIndex = index;
+	scanDiscard = scanList[index].discard;
+	scanConversions = 0;
+	scanSum = 0;
+	
+	ADMUX = scanList[index].reference | (scanList[index].channel & 0x1F);
+}
+
+
+/**
+ *
+ * @brief Reset the scan sequencer and the frame ring buffer
+ *
+ * @return void
+ *
+*/
+static void ADC_ScanReset(void)
+{
+	frameHead = 0;
+	frameTail = 0;
+	droppedFrames = 0;
+	freerunDivider = 0;
+	scanSequence = 0;
+	
+	ADC_ScanSelect(0);
+}
+
+
+/**
+ *
+ * @brief Start free running scans
+ *
+ * The ADC scans continuously and the ADC complete interrupt stores every
+ * ADC_FREERUN_DIVIDER-th frame in the frame ring buffer.
+ * With a prescaler of /128 the ADC clock is inside the specified range of 50...200 kHz.
+ *
+ * @note ADC_Read() and ADC_ReadAvg() must not be used while background acquisition is active.
+ *
+ * @return void
+ *
+*/
+void ADC_StartFreeRunning(void)
+{
+	if(scanCount == 0)
+	return;
+	
+	uint8_t sreg = SREG;
+	cli();
+	
+	triggerSource = ADC_TRIGGER_FREERUN;
+	
+	ADC_ScanReset();
+	
+	// activate ADC with prescaler /128 and conversion complete interrupt,
+	// every conversion is started by the interrupt (multiplexer changes are synchronous)
+	ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+	
+	ADCSRA |= (1 << ADSC);							// start first conversion
+	
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Start timer triggered scans
+ *
+ * Every compare match of the selected timer starts one scan in hardware, the following
+ * conversions of the scan are started by the ADC complete interrupt.
+ * Each frame is stored in the frame ring buffer.
+ *
+ * ADC_TRIGGER_TIMER0: Timer0 compare match A, period of 10ms configured in init_Ports().
+ * ADC_TRIGGER_TIMER1: Timer1 of the timebase (normal mode, prescaler /8), the compare match B
+ * register is moved forward by period in the compare interrupt.
+ *
+ * @note the period has to be longer than the time for all conversions of one scan.
+ *
+ * @param source auto trigger source (ADC_TRIGGER_TIMER0 or ADC_TRIGGER_TIMER1)
+ * @param period Timer1 ticks between two scans (only used for ADC_TRIGGER_TIMER1)
+ *
+ * @return void
+ *
+*/
+void ADC_StartTriggered(uint8_t source, uint16_t period)
+{
+	if(scanCount == 0)
+	return;
+	
+	uint8_t sreg = SREG;
+	cli();
+	
+	ADCSRA &= ~((1 << ADATE) | (1 << ADIE));		// stop running conversions
+	
+	triggerSource = source;
+	triggerPeriod = period;
+	
+	ADC_ScanReset();
+	
+	if(source == ADC_TRIGGER_TIMER1)
+	{
+		// Timer1 is the timebase (normal mode, prescaler /8)
+		Timebase_Init();
+		
+		OCR1B = TCNT1 + period;
+		TIFR1 = (1 << OCF1B);						// clear pending compare match
+		TIMSK1 |= (1 << OCIE1B);
+	}
+	
+	ADCSRB = source;								// select auto trigger source
+	
+	// activate ADC with prescaler /128, auto trigger and conversion complete interrupt
+	ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+	
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Stop background conversions
+ *
+ * Restore single conversion mode. Frames already stored in the ring buffer stay available.
+ *
+ * @return void
+ *
+*/
+void ADC_Stop(void)
+{
+	ADCSRA &= ~((1 << ADATE) | (1 << ADIE));	// disable auto trigger and interrupt
+	
+	TIMSK1 &= ~(1 << OCIE1B);					// stop Timer1 trigger
+	
+	while(ADCSRA & (1 << ADSC));				// wait until running conversion finished
+	
+	ADCSRA = (1 << ADEN) | (1 << ADPS1) | (1 << ADPS0);	// single mode with prescaler /8 (see ADC_Init)
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Count of frames ready to read
+ *
+ * @return count of frames in the ring buffer
+ *
+*/
+uint8_t ADC_Available(void)
+{
+	return (uint8_t)(frameHead - frameTail) & ADC_BUFFER_MASK;
+}
+
+
+/**
+ *
+ * @brief Take the oldest frame out of the ring buffer
+ *
+ * Only the main loop is allowed to call this function (single consumer).
+ *
+ * @param frame Pointer for a copy of the frame
+ *
+ * @return true: frame read | false: ring buffer empty
+ *
+*/
+bool ADC_PopFrame(ADC_Frame *frame)
+{
+	uint8_t tail = frameTail;
+	
+	if(tail == frameHead)
+	return false;
+	
+	for(uint8_t i = 0; i < ADC_SCAN_MAX_CHANNELS; i++)
+	frame->value[i] = frameBuffer[tail].value[i];
+	
+	frame->sequence = frameBuffer[tail].sequence;
+	frame->timestamp = frameBuffer[tail].timestamp;
+	
+	// release the slot after the frame was read
+	frameTail = (tail + 1) & ADC_BUFFER_MASK;
+	
+	return true;
+}
+
+
+/**
+ *
+ * @brief Count of frames dropped because the ring buffer was full
+ *
+ * @return count of dropped frames since the start of background acquisition
+ *
+*/
+uint16_t ADC_GetDroppedFrames(void)
+{
+	uint16_t dropped;
+	
+	uint8_t sreg = SREG;
+	cli();
+	dropped = droppedFrames;
+	SREG = sreg;
+	
+	return dropped;
+}
+
+
+/**
+ *
+ * @brief Register a callback for every sample of a channel
+ *
+ * The callback is executed in the ADC interrupt for every published frame, even
+ * if the frame gets dropped because the ring buffer is full.
+ *
+ * @param index index of the channel in the scan list
+ * @param callback callback function (0: no callback)
+ *
+ * @return void
+ *
+*/
+void ADC_SetSampleCallback(uint8_t index, ADC_SampleCallback callback)
+{
+	uint8_t sreg = SREG;
+	cli();
+	sampleIndex = (index < ADC_SCAN_MAX_CHANNELS) ? index : 0;
+	sampleCallback = callback;
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Activate trigger-to-read latency measurement
+ *
+ * The latency is the time between the timer compare match (start of the scan)
+ * and the readout of the first result of the scan in the ADC complete interrupt.
+ * Enabling resets the statistics.
+ *
+ * @param enable true: start measurement | false: stop measurement
+ *
+ * @return void
+ *
+*/
+void ADC_EnableJitterMeasurement(bool enable)
+{
+	uint8_t sreg = SREG;
+	cli();
+	
+	if(enable)
+	{
+		jitter.min = 0xFFFF;
+		jitter.max = 0;
+		jitter.last = 0;
+		jitter.sum = 0;
+		jitter.count = 0;
+	}
+	jitterEnabled = enable;
+	
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Read trigger-to-read latency statistics
+ *
+ * @param stat Pointer for a copy of the statistics
+ *
+ * @return void
+ *
+*/
+void ADC_GetJitter(ADC_JitterStat *stat)
+{
+	uint8_t sreg = SREG;
+	cli();
+	
+	stat->min = jitter.min;
+	stat->max = jitter.max;
+	stat->last = jitter.last;
+	stat->sum = jitter.sum;
+	stat->count = jitter.count;
+	
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Record trigger-to-read latency
+ *
+ * Called from the ADC complete interrupt.
+ *
+ * @return void
+ *
+*/
+static inline void ADC_RecordJitter(void)
+{
+	uint16_t latency;
+	
+	if(triggerSource == ADC_TRIGGER_TIMER1)
+	latency = TCNT1 - triggerStamp;
+	else
+	latency = (uint16_t)TCNT0 * 128;	// Timer0 is cleared at compare match, prescaler 1024 = 128 * 8
+	
+	jitter.last = latency;
+	if(latency < jitter.min) jitter.min = latency;
+	if(latency > jitter.max) jitter.max = latency;
+	jitter.sum += latency;
+	
+	// stop at counter overflow to keep the mean value valid
+	if(++jitter.count == 0xFFFF) jitterEnabled = false;
+}
+
+
+/**
+ *
+ * @brief Timestamp of the frame in conversion
+ *
+ * Timer1 triggered scans use the compare value of the trigger, all other modes the
+ * time of the first conversion result. Called from the ADC complete interrupt.
+ *
+ * @return void
+ *
+*/
+static inline void ADC_StampFrame(void)
+{
+	uint32_t now = Timebase_Ticks();
+	
+	if(triggerSource == ADC_TRIGGER_TIMER1)
+	now = Timebase_Extend(now, triggerStamp);
+	
+	frameBuffer[frameHead].timestamp = now;
+}
+
+
+/**
+ *
+ * @brief Publish the frame of a finished scan
+ *
+ * The frame was written directly into the head slot of the ring buffer. This slot is
+ * never read by the main loop until the head index is moved forward.
+ *
+ * @return void
+ *
+*/
+static inline void ADC_PublishFrame(void)
+{
+	uint8_t head = frameHead;
+	uint8_t next = (head + 1) & ADC_BUFFER_MASK;
+	
+	frameBuffer[head].sequence = scanSequence++;
+	
+	// full rate sample stream, independent of the state of the ring buffer
+	if(sampleCallback)
+	sampleCallback(frameBuffer[head].value[sampleIndex]);
+	
+	// ring buffer full? -> the slot will be overwritten by the next scan
+	if(next == frameTail)
+	{
+		droppedFrames++;
+		return;
+	}
+	
+	// publish the frame after it was written
+	frameHead = next;
+}
+
+
+/**
+ *
+ * @brief Interrupt function for Timer1 compare match B
+ *
+ * Move the compare register forward by one sample period. The compare match
+ * itself already started the conversion in hardware, the interrupt only clears the
+ * flag so the next compare match generates a new trigger edge.
+ *
+*/
+ISR(TIMER1_COMPB_vect)
+{
+	triggerStamp = OCR1B;
+	OCR1B += triggerPeriod;
+}
+
+
+/**
+ *
+ * @brief Interrupt function for ADC conversion complete
+ *
+ * Scan sequencer: discard conversions after a channel switch, sum up the 4^n oversampling
+ * conversions, decimate them by n bits and switch to the next channel of the scan list. At the end of the scan
+ * the frame gets published (every ADC_FREERUN_DIVIDER-th frame in free running mode).
+ * The oldest frames are never overwritten, if the buffer is full the new frame gets dropped.
+ *
+*/
+ISR(ADC_vect)
+{
+	uint16_t value = ADCW;
+	
+	// first conversion of a scan
+	if(scanIndex == 0 && scanConversions == 0 && scanDiscard == scanList[0].discard)
+	{
+		ADC_StampFrame();
+		
+		if(jitterEnabled && triggerSource != ADC_TRIGGER_FREERUN)
+		ADC_RecordJitter();
+	}
+	
+	// settling time after switching the multiplexer
+	if(scanDiscard)
+	{
+		scanDiscard--;
+		ADCSRA |= (1 << ADSC);
+		return;
+	}
+	
+	scanSum += value;
+	
+	// oversampling: sum of 4^n conversions
+	if(++scanConversions < ((uint16_t)1 << (2 * scanList[scanIndex].extraBits)))
+	{
+		ADCSRA |= (1 << ADSC);
+		return;
+	}
+	
+	// decimation: 10+n bit result
+	frameBuffer[frameHead].value[scanIndex] = (uint16_t)(scanSum >> scanList[scanIndex].extraBits);
+	
+	// next channel of the scan
+	if(scanIndex + 1 < scanCount)
+	{
+		ADC_ScanSelect(scanIndex + 1);
+		ADCSRA |= (1 << ADSC);
+		return;
+	}
+	
+	// scan finished, prepare the multiplexer for the next scan
+	ADC_ScanSelect(0);
+	
+	if(triggerSource == ADC_TRIGGER_FREERUN)
+	{
+		if(++freerunDivider >= ADC_FREERUN_DIVIDER)
+		{
+			freerunDivider = 0;
+			ADC_PublishFrame();
+		}
+		
+		ADCSRA |= (1 << ADSC);
+		return;
+	}
+	
+	ADC_PublishFrame();
+}
@@ -30,7 +30,73 @@
 #define ADC_H_
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#define ADC_BUFFER_SIZE			8		/**< size of the frame ring buffer (power of 2)			*/
+#define ADC_BUFFER_MASK			(ADC_BUFFER_SIZE - 1)	/**< index mask of the frame ring buffer	*/
+#define ADC_FREERUN_DIVIDER		32		/**< store every n-th scan in free running mode			*/
+
+#define ADC_SCAN_MAX_CHANNELS	4		/**< max. count of channels in a scan					*/
+#define ADC_MAX_EXTRA_BITS		6		/**< max. additional bits by oversampling (16 bit result)	*/
+
+#define ADC_REF_AREF			0								/**< reference voltage: AREF pin		*/
+#define ADC_REF_AVCC			(1 << REFS0)					/**< reference voltage: AVCC			*/
+#define ADC_REF_INTERNAL		((1 << REFS1) | (1 << REFS0))	/**< reference voltage: internal 1.1V	*/
+
+#define ADC_TRIGGER_FREERUN		0		/**< auto trigger source: free running mode				*/
+#define ADC_TRIGGER_TIMER0		3		/**< auto trigger source: Timer0 compare match A		*/
+#define ADC_TRIGGER_TIMER1		5		/**< auto trigger source: Timer1 compare match B		*/
+
+#define ADC_TIMER1_TICKS_PER_MS	(F_CPU / 8 / 1000)	/**< Timer1 ticks per millisecond (prescaler /8)	*/
+
+/**
+*
+* @brief Channel configuration of the scan list
+*
+*/
+typedef struct _ADC_ScanChannel{
+	uint8_t channel;		/**< ADC channel of the uC										*/
+	uint8_t reference;		/**< reference voltage (ADC_REF_...)								*/
+	uint8_t extraBits;		/**< oversampling: 4^n conversions decimated to 10+n bits (0...6)	*/
+	uint8_t discard;		/**< conversions discarded after switching to this channel		*/
+}ADC_ScanChannel;
+
+/**
+*
+* @brief Results of one scan
+*
+*/
+typedef struct _ADC_Frame{
+	uint16_t value[ADC_SCAN_MAX_CHANNELS];	/**< value of every channel of the scan list (10+extraBits bits)	*/
+	uint32_t timestamp;						/**< Timebase ticks at the start of the scan	*/
+	uint8_t sequence;						/**< scan counter (gaps = dropped frames)		*/
+}ADC_Frame;
+
+/**
+*
+* @brief Trigger-to-read latency statistics
+*
+* All values in Timer1 ticks (prescaler /8).
+*
+*/
+typedef struct _ADC_JitterStat{
+	uint16_t min;		/**< minimum latency			*/
+	uint16_t max;		/**< maximum latency			*/
+	uint16_t last;		/**< latency of the last sample	*/
+	uint32_t sum;		/**< sum of all latencies		*/
+	uint16_t count;		/**< count of measurements		*/
+}ADC_JitterStat;
+
+/**
+*
+* @brief Callback for every sample of a scan channel
+*
+* Called from the ADC interrupt, must return quickly.
+*
+*/
+typedef void (*ADC_SampleCallback)(uint16_t value);
 
 void ADC_Init(void);
 
@@ -38,6 +104,29 @@ uint16_t ADC_Read(uint8_t channel);
 
 uint16_t ADC_ReadAvg(uint8_t channel, uint8_t nsamples);
 
+uint16_t ADC_ReadOversampled(uint8_t channel, uint8_t extraBits);
+
+void ADC_ScanConfigure(const ADC_ScanChannel *channels, uint8_t count);
+
+uint8_t ADC_GetScanChannelCount(void);
+
+void ADC_StartFreeRunning(void);
+
+void ADC_StartTriggered(uint8_t source, uint16_t period);
+
+void ADC_Stop(void);
+
+void ADC_EnableJitterMeasurement(bool enable);
+
+void ADC_GetJitter(ADC_JitterStat *stat);
+
+uint8_t ADC_Available(void);
+
+bool ADC_PopFrame(ADC_Frame *frame);
+
+uint16_t ADC_GetDroppedFrames(void);
+
+void ADC_SetSampleCallback(uint8_t index, ADC_SampleCallback callback);
 
 
 #endif /* ADC_H_ */
\ No newline at end of file
@@ -0,0 +1,243 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file capture.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Triggered capture library
+ *
+ * The sample stream of one channel is written into a circular history buffer.
+ * A rising threshold crossing or a step between two samples (slope) triggers the
+ * capture. After the post-trigger samples are recorded the burst gets frozen
+ * until it is read out and the capture is armed again.
+ *
+ * Capture_Sample() is called from the ADC interrupt and runs in constant time.
+ *
+*/
+
+#include "capture.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static uint16_t history[CAPTURE_BUFFER_SIZE];	/**< circular sample history					*/
+static volatile uint8_t head = 0;				/**< write index of the history					*/
+static volatile uint8_t filled = 0;				/**< valid pre-trigger samples in the history	*/
+static volatile bool primed = false;			/**< previous sample for the trigger available	*/
+static volatile uint8_t state = CAPTURE_IDLE;	/**< capture state (CAPTURE_...)				*/
+static volatile uint8_t remaining = 0;			/**< post-trigger samples left to record		*/
+static volatile uint8_t burstStart = 0;			/**< history index of the first burst sample	*/
+static volatile uint8_t burstLength = 0;		/**< count of samples in the burst				*/
+static volatile uint8_t burstPre = 0;			/**< pre-trigger samples in the burst			*/
+static volatile uint16_t lastValue = 0;			/**< previous sample							*/
+
+static uint16_t triggerThreshold = 0;			/**< rising threshold (0: disabled)				*/
+static uint16_t triggerSlope = 0;				/**< min. step between two samples (0: disabled)	*/
+static uint8_t preSamples = 0;					/**< configured pre-trigger samples				*/
+static uint8_t postSamples = 0;					/**< configured post-trigger samples			*/
+
+
+/**
+*
+* @brief Initialize the triggered capture
+*
+* Pre- and post-trigger samples are limited to the history size
+* (pre + trigger sample + post <= CAPTURE_BUFFER_SIZE). The capture is armed afterwards.
+*
+* @param threshold trigger on a rising crossing of this value (0: disabled)
+* @param slope trigger on a difference of at least this value between two samples (0: disabled)
+* @param pre count of samples before the trigger
+* @param post count of samples after the trigger
+*
+* @return void
+*
+*/
+void Capture_Init(uint16_t threshold, uint16_t slope, uint8_t pre, uint8_t post)
+{
+	if(pre > CAPTURE_BUFFER_SIZE - 1)
+	pre = CAPTURE_BUFFER_SIZE - 1;
+	
+	if(post > CAPTURE_BUFFER_SIZE - 1 - pre)
+	post = CAPTURE_BUFFER_SIZE - 1 - pre;
+	
+	uint8_t sreg = SREG;
+	cli();
+	triggerThreshold = threshold;
+	triggerSlope = slope;
+	preSamples = pre;
+	postSamples = post;
+	SREG = sreg;
+	
+	Capture_Arm();
+	
+	return;
+}
+
+/**
+*
+* @brief Arm the capture
+*
+* Release a frozen burst and wait for the next trigger. The history gets refilled
+* before a new trigger is accepted.
+*
+* @return void
+*
+*/
+void Capture_Arm(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	filled = 0;
+	primed = false;
+	state = CAPTURE_ARMED;
+	SREG = sreg;
+	
+	return;
+}
+
+/**
+*
+* @brief Process a new sample
+*
+* @note called from the ADC interrupt
+*
+* @param value sample value
+*
+* @return void
+*
+*/
+void Capture_Sample(uint16_t value)
+{
+	if(state == CAPTURE_IDLE || state == CAPTURE_READY)
+	return;
+	
+	uint8_t index = head;
+	history[index] = value;
+	head = (index + 1) & CAPTURE_BUFFER_MASK;
+	
+	if(state == CAPTURE_TRIGGERED)
+	{
+		if(--remaining == 0)
+		state = CAPTURE_READY;
+		
+		return;
+	}
+	
+	// armed: the first sample has no predecessor for the trigger conditions
+	uint16_t previous = lastValue;
+	lastValue = value;
+	
+	if(!primed)
+	{
+		primed = true;
+		if(preSamples > 0)
+		filled = 1;
+		
+		return;
+	}
+	
+	bool trigger = false;
+	
+	if(triggerThreshold != 0 && previous < triggerThreshold && value >= triggerThreshold)
+	trigger = true;
+	
+	if(triggerSlope != 0)
+	{
+		uint16_t step = (value > previous) ? value - previous : previous - value;
+		if(step >= triggerSlope)
+		trigger = true;
+	}
+	
+	if(!trigger)
+	{
+		if(filled < preSamples)
+		filled++;
+		
+		return;
+	}
+	
+	// freeze the pre-trigger samples, the trigger sample is part of the burst
+	burstPre = filled;
+	burstStart = (index - filled) & CAPTURE_BUFFER_MASK;
+	burstLength = filled + 1 + postSamples;
+	remaining = postSamples;
+	
+	state = (postSamples == 0) ? CAPTURE_READY : CAPTURE_TRIGGERED;
+	
+	return;
+}
+
+/**
+*
+* @brief Read the capture state
+*
+* @return CAPTURE_IDLE | CAPTURE_ARMED | CAPTURE_TRIGGERED | CAPTURE_READY
+*
+*/
+uint8_t Capture_GetState(void)
+{
+	return state;
+}
+
+/**
+*
+* @brief Count of samples in the frozen burst
+*
+* @return count of samples (0: no burst available)
+*
+*/
+uint8_t Capture_GetLength(void)
+{
+	if(state != CAPTURE_READY)
+	return 0;
+	
+	return burstLength;
+}
+
+/**
+*
+* @brief Count of pre-trigger samples in the frozen burst
+*
+* The trigger sample is the sample with this index.
+*
+* @return count of pre-trigger samples
+*
+*/
+uint8_t Capture_GetPreTrigger(void)
+{
+	return burstPre;
+}
+
+/**
+*
+* @brief Read a sample of the frozen burst
+*
+* @param index index in the burst (0: oldest sample)
+*
+* @return sample value
+*
+*/
+uint16_t Capture_GetSample(uint8_t index)
+{
+	return history[(burstStart + index) & CAPTURE_BUFFER_MASK];
+}
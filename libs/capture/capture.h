@@ -0,0 +1,57 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file capture.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAPTURE_BUFFER_SIZE		64		/**< history size in samples (power of 2, 2 byte per sample)	*/
+#define CAPTURE_BUFFER_MASK		(CAPTURE_BUFFER_SIZE - 1)	/**< index mask of the history		*/
+
+#define CAPTURE_IDLE			0		/**< capture disabled									*/
+#define CAPTURE_ARMED			1		/**< waiting for the trigger condition					*/
+#define CAPTURE_TRIGGERED		2		/**< recording the post-trigger samples					*/
+#define CAPTURE_READY			3		/**< burst frozen, waiting for readout					*/
+
+void Capture_Init(uint16_t threshold, uint16_t slope, uint8_t pre, uint8_t post);
+
+void Capture_Arm(void);
+
+void Capture_Sample(uint16_t value);
+
+uint8_t Capture_GetState(void);
+
+uint8_t Capture_GetLength(void);
+
+uint8_t Capture_GetPreTrigger(void);
+
+uint16_t Capture_GetSample(uint8_t index);
+
+#endif /* CAPTURE_H_ */
@@ -32,6 +32,7 @@
 */
 
 #include "delay.h"
+#include "../scheduler/scheduler.h"
 
 uint16_t pulseCount;	/**< Pulse counter of the delay function */
 
@@ -52,6 +53,8 @@ void delayPulseSteps(bool *pulse, uint16_t count)
 	
 	while(pulseCount < count)
 	{
+		Scheduler_Yield();	// background tasks
+		
 		if(*pulse)
 		{
 			*pulse = false;
@@ -0,0 +1,227 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file encoding.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Compact sample encoding
+ *
+ * Blocks of (timestamp, value) samples are stored as a base sample followed by
+ * deltas. Timestamps are monotonic, so the time delta is an unsigned varint.
+ * Value deltas are signed and zig-zag mapped before the varint encoding, which
+ * results in one byte for changes of -64...63 and an equidistant sample rate.
+ * The blocks keep the samples of a batch in RAM until the upload (batchRoutine);
+ * the network payload is the CSV body formatted from them, the SD spool stores
+ * fixed size records.
+ *
+*/
+
+#include "encoding.h"
+
+/**
+*
+* @brief Write a varint (7 bit per byte, LSB first, MSB set if more bytes follow)
+*
+* @param out Pointer to the output
+* @param value value to encode
+*
+* @return count of written bytes (1...5)
+*
+*/
+static uint8_t Encode_Varint(uint8_t *out, uint32_t value)
+{
+	uint8_t length = 0;
+	
+	while(value >= 0x80)
+	{
+		out[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	
+	out[length++] = (uint8_t)value;
+	
+	return length;
+}
+
+/**
+*
+* @brief Read a varint
+*
+* @param block Pointer of the decoder state
+* @param value Pointer for the decoded value
+*
+* @return true: success | false: end of the block or invalid varint
+*
+*/
+static bool Decode_Varint(DecodeBlock *block, uint32_t *value)
+{
+	uint32_t result = 0;
+	
+	for(uint8_t shift = 0; shift < 35; shift += 7)
+	{
+		if(block->position >= block->length)
+		return false;
+		
+		uint8_t byte = block->buffer[block->position++];
+		result |= (uint32_t)(byte & 0x7F) << shift;
+		
+		if((byte & 0x80) == 0)
+		{
+			*value = result;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+/**
+*
+* @brief Start a new block
+*
+* @param block Pointer of the encoder state
+* @param buffer output buffer
+* @param size size of the output buffer
+*
+* @return void
+*
+*/
+void Encode_Begin(EncodeBlock *block, uint8_t *buffer, uint16_t size)
+{
+	block->buffer = buffer;
+	block->size = size;
+	block->length = 0;
+	block->count = 0;
+	block->lastTime = 0;
+	block->lastValue = 0;
+}
+
+/**
+*
+* @brief Append a sample to the block
+*
+* The first sample of a block is stored as base (absolute values).
+* Timestamps must not decrease.
+*
+* @param block Pointer of the encoder state
+* @param time timestamp of the sample
+* @param value sample value
+*
+* @return true: sample added | false: buffer full or timestamp out of order
+*
+*/
+bool Encode_Add(EncodeBlock *block, uint32_t time, uint16_t value)
+{
+	uint8_t sample[ENCODE_MAX_SAMPLE_SIZE];
+	uint8_t length;
+	
+	if(block->count == 0)
+	{
+		length = Encode_Varint(sample, time);
+		length += Encode_Varint(&sample[length], value);
+	}
+	else
+	{
+		if(time < block->lastTime)
+		return false;
+		
+		// zig-zag: 0, -1, 1, -2, 2 ... -> 0, 1, 2, 3, 4 ...
+		int32_t delta = (int32_t)value - (int32_t)block->lastValue;
+		uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+		
+		length = Encode_Varint(sample, time - block->lastTime);
+		length += Encode_Varint(&sample[length], zigzag);
+	}
+	
+	if(block->length + length > block->size)
+	return false;
+	
+	for(uint8_t i = 0; i < length; i++)
+	block->buffer[block->length++] = sample[i];
+	
+	block->count++;
+	block->lastTime = time;
+	block->lastValue = value;
+	
+	return true;
+}
+
+/**
+*
+* @brief Start decoding of a block (reference decoder)
+*
+* @param block Pointer of the decoder state
+* @param buffer encoded block
+* @param length length of the encoded block
+*
+* @return void
+*
+*/
+void Decode_Begin(DecodeBlock *block, const uint8_t *buffer, uint16_t length)
+{
+	block->buffer = buffer;
+	block->length = length;
+	block->position = 0;
+	block->count = 0;
+	block->lastTime = 0;
+	block->lastValue = 0;
+}
+
+/**
+*
+* @brief Decode the next sample of a block
+*
+* @param block Pointer of the decoder state
+* @param time Pointer for the timestamp
+* @param value Pointer for the sample value
+*
+* @return true: sample decoded | false: end of the block or invalid data
+*
+*/
+bool Decode_Next(DecodeBlock *block, uint32_t *time, uint16_t *value)
+{
+	uint32_t first, second;
+	
+	if(!Decode_Varint(block, &first) || !Decode_Varint(block, &second))
+	return false;
+	
+	if(block->count == 0)
+	{
+		block->lastTime = first;
+		block->lastValue = (uint16_t)second;
+	}
+	else
+	{
+		int32_t delta = (int32_t)(second >> 1) ^ -(int32_t)(second & 1);
+		
+		block->lastTime += first;
+		block->lastValue = (uint16_t)((int32_t)block->lastValue + delta);
+	}
+	
+	block->count++;
+	*time = block->lastTime;
+	*value = block->lastValue;
+	
+	return true;
+}
@@ -0,0 +1,76 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file encoding.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef ENCODING_H_
+#define ENCODING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ENCODE_MAX_SAMPLE_SIZE	8		/**< max. size of an encoded sample (5 byte time + 3 byte value)	*/
+
+/**
+*
+* @brief Encoder state of a sample block
+*
+* Block layout: varint base time, varint base value, then for every further
+* sample a varint time delta and a zig-zag varint value delta.
+*
+*/
+typedef struct _EncodeBlock{
+	uint8_t *buffer;		/**< output buffer					*/
+	uint16_t size;			/**< size of the output buffer		*/
+	uint16_t length;		/**< used bytes of the buffer		*/
+	uint16_t count;			/**< count of encoded samples		*/
+	uint32_t lastTime;		/**< timestamp of the last sample	*/
+	uint16_t lastValue;		/**< value of the last sample		*/
+}EncodeBlock;
+
+/**
+*
+* @brief Decoder state of a sample block
+*
+*/
+typedef struct _DecodeBlock{
+	const uint8_t *buffer;	/**< encoded block					*/
+	uint16_t length;		/**< length of the encoded block	*/
+	uint16_t position;		/**< read position					*/
+	uint16_t count;			/**< count of decoded samples		*/
+	uint32_t lastTime;		/**< timestamp of the last sample	*/
+	uint16_t lastValue;		/**< value of the last sample		*/
+}DecodeBlock;
+
+void Encode_Begin(EncodeBlock *block, uint8_t *buffer, uint16_t size);
+
+bool Encode_Add(EncodeBlock *block, uint32_t time, uint16_t value);
+
+void Decode_Begin(DecodeBlock *block, const uint8_t *buffer, uint16_t length);
+
+bool Decode_Next(DecodeBlock *block, uint32_t *time, uint16_t *value);
+
+#endif /* ENCODING_H_ */
@@ -44,6 +44,9 @@
 #include "tuxgraphics/dnslkup.h"
 #include "tuxgraphics/dhcp_client.h"
 
+#include "../timebase/timebase.h"
+#include "../scheduler/scheduler.h"
+
 static uint8_t deviceMac[6] = { 0x6A, 0x77, 0x6A, 0x10, 0x00, 0x29};	/**< MAC address of the datalogger (unique in network) */
 
 static uint8_t deviceIP[4] = {192, 168, 130, 20};						/**< locale IP (configured over dhcp) */
@@ -52,9 +55,6 @@ static uint8_t deviceGw[4] = {192, 168, 130, 1};						/**< Gateway IP (configure
 
 static uint8_t netmask[4] = {255, 255, 255, 0};							/**< Netmask of the local network (configured over dhcp) */
 	
-#define TRANS_NUM_GWMAC 1	/**< Transaction number for dhcp gateway MAC */
-static uint8_t gwmac[6];	/**< Gateway MAC address*/
-
 static uint8_t destIP[4]; /**< Target IP */
 
 /**
@@ -68,16 +68,34 @@ typedef enum
 {
 	dnsStateIdle,
 	dnsStateRequestSent,
-	dnsStateHaveAnswer	
+	dnsStateHaveAnswer,
+	dnsStateRefreshSent		/**< refresh in the background, the last address is valid */
 }dnsStateEnum;
 
 static dnsStateEnum dns_state = dnsStateIdle; /**< Current DNS state */
+static const char *dnsHost = NULL;		/**< host of the DNS lookup					*/
+static uint32_t dnsRefresh = 0;			/**< time of the next lookup (Timebase_Millis)	*/
+static uint32_t dnsRequestTime = 0;		/**< time of the last request (Timebase_Millis)	*/
 
 
 #define BUFFER_SIZE	650					/**< Recv/Transmit Buffer size	*/
 static uint8_t buf[BUFFER_SIZE+1];		/**< Buffer storage				*/
-static uint8_t startWebClient = 0;		/**< Web Client status			*/
-static uint8_t gwArpState = 0;			/**< Gateway detection status	*/
+static uint32_t stackLastTick = 0;		/**< last 1 s tick of the stack timers (Timebase_Millis)	*/
+static bool linkReady = false;			/**< controller initialized		*/
+static bool bufferBusy = false;			/**< buffer used by a blocking request	*/
+
+static volatile bool rxPending = true;	/**< packet signaled by the INT pin of the controller	*/
+static uint32_t rxLastCheck = 0;		/**< last read of the packet counter (Timebase_Millis)	*/
+
+static uint16_t (*fillCallback)(char *data, uint16_t size);	/**< body generator of a POST request, query generator of a GET request */
+
+#define ETHERNET_REQUEST_PENDING	0	/**< no answer yet								*/
+#define ETHERNET_REQUEST_OK			1	/**< answer accepted							*/
+#define ETHERNET_REQUEST_FAILED		2	/**< answer rejected, connection reset or timeout	*/
+
+static uint16_t (*tcpDataCallback)(char *data, uint16_t size, bool reused);	/**< data generator of a TCP request	*/
+static bool (*tcpAnswerCallback)(char *data, uint16_t length);				/**< answer check of a TCP request		*/
+static uint8_t requestResult = ETHERNET_REQUEST_PENDING;					/**< result of the HTTP/TCP request		*/
 
 /**
 *
@@ -102,8 +120,8 @@ void pingCallback(uint8_t *ip)
 *
 * This function get called, when a response to a http request is available.
 *
-* Callback set the http status code to 200. The web client set to wait mode to
-* be able to send a new request.
+* A 2xx status code ends the request successful, every other status code, a reset
+* or a timeout (webStatusCode 0) as failed.
 *
 * @note die __attribute__((unused)) is a GCC Compiler directive to avoid warning while compiling.
 *
@@ -115,35 +133,115 @@ void pingCallback(uint8_t *ip)
 void browserresultCallback(uint8_t webStatusCode,uint16_t datapos __attribute__((unused)), uint16_t len __attribute__((unused)))
 {
 	if(webStatusCode == 2)
-	{
-		startWebClient = 3;	// waiting mode
-	}
+	requestResult = ETHERNET_REQUEST_OK;
 	else
-	{
-		startWebClient = 0; // Stopped
-	}
+	requestResult = ETHERNET_REQUEST_FAILED;
 }
 
 
 /**
 *
-* @brief ARP Request Callback function
+* @brief Interrupt function for the INT pin of the ENC28J60
 *
-* This function get called, whe a arp request is reveived.
-* Received mac address will be copied to gateway mac-address.
+* The INT pin stays low while packets are pending (low level interrupt). The interrupt
+* disables itself until the packets are read out by Ethernet_Receive().
 *
-* @note die __attribute__((unused)) is a GCC Compiler directive to avoid warning while compiling.
+*/
+ISR(INT0_vect)
+{
+	EIMSK &= ~(1 << INT0);
+	rxPending = true;
+}
+
+/**
 *
-* @param transactionNumber transaction number of the arp request.
-* @param mac MAC address of the gateway
+* @brief Activate the receive interrupt
 *
 * @return void
 *
 */
-void arpresolverResultCallback(uint8_t *ip __attribute__((unused)),uint8_t transactionNumber,uint8_t *mac)
+static void Ethernet_EnableRxInterrupt(void)
+{
+	ETHERNET_INT_DDR &= ~(1 << ETHERNET_INT_PIN);	// input with pull-up (open drain output of the controller)
+	ETHERNET_INT_PORT |= (1 << ETHERNET_INT_PIN);
+	
+	uint8_t sreg = SREG;
+	cli();
+	EICRA &= ~((1 << ISC01) | (1 << ISC00));		// low level
+	EIFR = (1 << INTF0);
+	EIMSK |= (1 << INT0);
+	SREG = sreg;
+	
+	linkReady = true;
+}
+
+/**
+*
+* @brief Receive a packet
+*
+* The controller is only accessed, if the INT pin signaled a packet. Every
+* ETHERNET_RX_FALLBACK ms the packet counter is read anyway (see ENC28J60 silicon
+* errata: the packet interrupt flag is not always reliable).
+*
+* @return length of the packet in buf (0: no packet)
+*
+*/
+static uint16_t Ethernet_Receive(void)
+{
+	uint32_t now = Timebase_Millis();
+	
+	if(!rxPending && now - rxLastCheck < ETHERNET_RX_FALLBACK)
+	return 0;
+	
+	rxLastCheck = now;
+	
+	uint16_t plen = enc28j60PacketReceive(BUFFER_SIZE, buf);
+	
+	// receive buffer empty -> wait for the next interrupt
+	if(plen == 0)
+	{
+		uint8_t sreg = SREG;
+		cli();
+		rxPending = false;
+		EIMSK |= (1 << INT0);	// fires immediately, if the INT pin is still low
+		SREG = sreg;
+	}
+	
+	return plen;
+}
+
+/**
+*
+* @brief MAC address of a target
+*
+* Targets in the local network are addressed directly, all other targets over the
+* gateway. The address is taken from the ARP cache of the stack, only unknown
+* addresses are resolved first (packets and background tasks are processed while
+* waiting, max. ETHERNET_ARP_TIMEOUT ms).
+*
+* @param target target ip
+*
+* @return MAC address for the ethernet header (NULL: no ARP answer)
+*
+*/
+static uint8_t* Ethernet_TargetMac(uint8_t *target)
 {
-	if (transactionNumber==TRANS_NUM_GWMAC)
-	memcpy( gwmac, mac, 6 );
+	uint16_t plen;
+	uint8_t *mac;
+	uint32_t start = Timebase_Millis();
+	
+	while((mac = arp_cache_nexthop(target)) == NULL)
+	{
+		if(Timebase_Millis() - start >= ETHERNET_ARP_TIMEOUT)
+		return NULL;
+		
+		Scheduler_Yield();	// background tasks (sampling)
+		
+		plen = Ethernet_Receive();
+		packetloop_arp_icmp_tcp(buf, plen);	// the arp request is sent without packet
+	}
+	
+	return mac;
 }
 
 /**
@@ -180,6 +278,9 @@ void Ethernet_InitDHCP()
 	dhcp_get_my_ip(deviceIP, netmask, deviceGw);	// read ip address from device
 	
 	client_ifconfig(deviceIP, netmask);				// transmit received ip to ethernet controller
+	client_set_gwip(deviceGw);
+	
+	Ethernet_EnableRxInterrupt();
 	
 	return;
 }
@@ -245,67 +346,368 @@ void Ethernet_InitStatic()
 	_delay_us(5);
 	enc28j60PhyWrite(PHLCON, 0x476);
 	while(enc28j60linkup() == 0);
-	client_ifconfig(deviceIP, NULL);
+	client_ifconfig(deviceIP, netmask);
+	client_set_gwip(deviceGw);
 	init_mac(deviceMac);
-	get_mac_with_arp(deviceGw, TRANS_NUM_GWMAC, &arpresolverResultCallback);
-	get_mac_with_arp_wait();
+	Ethernet_EnableRxInterrupt();
 	return;
 }
 
 /**
-*s
-* @brief Send GET request
 *
-* @param value value to send
-* @param request_url url of the request (without hostname)
-* @param host hostname (eg. api.thingspeak.com)
+* @brief Wait for the end of a request
 *
-* @return void
+* Process the packets until the result callback of the request is executed. The
+* TCP client of the stack ends every request after its timeouts and retries
+* (client_tcp_tick), ETHERNET_REQUEST_TIMEOUT limits the wait also if the stack
+* misses the end of a request.
+*
+* @return true: request successful | false: failed
 *
 */
-void Ethernet_SendGET_p(bool useIP, char* value, const char* requestUrl, uint8_t* ip, const char* host)
+static bool Ethernet_WaitRequest(void)
 {
 	uint16_t plen, dat_p;
-
-	uint8_t endTransfer = 0;
-	while(!endTransfer)
+	uint32_t start = Timebase_Millis();
+	
+	while(requestResult == ETHERNET_REQUEST_PENDING)
 	{
-		plen = enc28j60PacketReceive(BUFFER_SIZE, buf);		// read packet buffer
-		dat_p = packetloop_arp_icmp_tcp(buf, plen);
-		
-		// data available?	- if data availble, start to stransmit
-		if(plen == 0)
+		if(Timebase_Millis() - start >= ETHERNET_REQUEST_TIMEOUT)
 		{
-			if(startWebClient == 1)
-			{
-				startWebClient = 2;
-				client_browse_url(requestUrl, value, host, &browserresultCallback, destIP, gwmac);
-			}
-			
-			// response available?
-			if(startWebClient == 3)
-			{
-				startWebClient = 1; // ready to send a new request
-				endTransfer = 1;
-			}
+			requestResult = ETHERNET_REQUEST_FAILED;
+			break;
 		}
 		
+		Scheduler_Yield();	// background tasks (sampling, timeouts)
+		
+		plen = Ethernet_Receive();		// read packet buffer (only if signaled)
+		dat_p = packetloop_arp_icmp_tcp(buf, plen);	// sends the syn/data without packet
+		
 		if(dat_p == 0)
 		{
 			// process incomming messages
 			// needed to make ping requests
 			udp_client_check_for_dns_answer(buf, plen);
-			continue;
 		}
 	}
 	
+	return requestResult == ETHERNET_REQUEST_OK;
+}
+
+/**
+*
+* @brief Request fill callback
+*
+* Pass the free space of the packet buffer to the body (POST) or query (GET) generator
+* of the application.
+*
+* @param buffer packet buffer
+* @param pos start position of the body/query in the tcp data
+*
+* @return position after the body/query
+*
+*/
+static uint16_t Ethernet_FillCallback(uint8_t *buffer, uint16_t pos)
+{
+	uint16_t offset = TCP_CHECKSUM_L_P + 3 + pos;
+	
+	if(offset >= BUFFER_SIZE)
+	return pos;
+	
+	return pos + fillCallback((char*)&buffer[offset], BUFFER_SIZE - offset);
+}
+
+/**
+*
+* @brief Send GET request
+*
+* The query is generated by a callback directly in the packet buffer, behind the
+* request url. The callback gets a pointer to the query and the free space in the
+* packet and returns the length of the written urlencoded query.
+*
+* @param useIP true: send to ip | false: send to the address of the DNS lookup
+* @param requestUrl url of the request (without hostname)
+* @param ip target ip (only with useIP)
+* @param host hostname (eg. api.thingspeak.com)
+* @param queryCallback query generator
+*
+* @return true: 2xx answer | false: no answer (timeout), reset or error status
+*
+*/
+bool Ethernet_SendGET_p(bool useIP, const char* requestUrl, uint8_t* ip, const char* host, uint16_t (*queryCallback)(char *query, uint16_t size))
+{
+	if(useIP)
+	Ethernet_SetDestIP(ip);
+	
+	fillCallback = queryCallback;
+	
+	bufferBusy = true;
+	
+	uint8_t *mac = Ethernet_TargetMac(destIP);
+	
+	if(mac == NULL)
+	{
+		bufferBusy = false;
+		return false;
+	}
+	
+	requestResult = ETHERNET_REQUEST_PENDING;
+	client_browse_url_fill(requestUrl, host, &Ethernet_FillCallback, &browserresultCallback, destIP, mac);
+	
+	bool success = Ethernet_WaitRequest();
+	
+	bufferBusy = false;
+	
+	return success;
+}
+
+/**
+*
+* @brief Send POST request
+*
+* The body is generated by a callback directly in the packet buffer. The callback
+* gets a pointer to the body and the free space in the packet and returns the
+* length of the written urlencoded body.
+*
+* @param useIP true: send to ip | false: send to the address of the DNS lookup
+* @param requestUrl url of the request (without hostname)
+* @param ip target ip (only with useIP)
+* @param host hostname (eg. api.thingspeak.com)
+* @param bodyCallback body generator
+*
+* @return true: 2xx answer | false: no answer (timeout), reset or error status
+*
+*/
+bool Ethernet_SendPOST_p(bool useIP, const char* requestUrl, uint8_t* ip, const char* host, uint16_t (*bodyCallback)(char *body, uint16_t size))
+{
+	if(useIP)
+	Ethernet_SetDestIP(ip);
+	
+	fillCallback = bodyCallback;
+
+	bufferBusy = true;
+	
+	uint8_t *mac = Ethernet_TargetMac(destIP);
+	
+	if(mac == NULL)
+	{
+		bufferBusy = false;
+		return false;
+	}
+	
+	requestResult = ETHERNET_REQUEST_PENDING;
+	client_http_post_fill(requestUrl, NULL, host, NULL, &Ethernet_FillCallback, &browserresultCallback, destIP, mac);
+	
+	bool success = Ethernet_WaitRequest();
+	
+	bufferBusy = false;
+	
+	return success;
+}
+
+/**
+*
+* @brief Send UDP datagram
+*
+* The payload is generated by a callback directly in the packet buffer. The callback
+* gets a pointer to the payload and the free space in the packet and returns the
+* length of the written data.
+*
+* @param ip target ip (NULL: ip of the last DNS lookup)
+* @param port target port
+* @param dataCallback payload generator
+*
+* @return true: datagram sent | false: no ARP answer of the target/gateway
+*
+*/
+bool Ethernet_SendUDP(uint8_t *ip, uint16_t port, uint16_t (*dataCallback)(char *data, uint16_t size))
+{
+	uint8_t *target = (ip != NULL) ? ip : destIP;
+	
+	bufferBusy = true;
+	
+	uint8_t *mac = Ethernet_TargetMac(target);
+	
+	if(mac == NULL)
+	{
+		bufferBusy = false;
+		return false;
+	}
+	
+	send_udp_prepare(buf, ETHERNET_UDP_SRC_PORT, target, port, mac);
+	
+	uint16_t len = dataCallback((char*)&buf[UDP_DATA_P], BUFFER_SIZE - UDP_DATA_P);
+	
+	send_udp_transmit(buf, len);
+	
+	bufferBusy = false;
+	
+	return true;
+}
+
+/**
+*
+* @brief TCP client fill callback
+*
+* Pass the TCP data of the packet buffer to the data generator of the application.
+*
+* @param fd file descriptor of the request
+*
+* @return length of the data
+*
+*/
+static uint16_t Ethernet_TCPFillCallback(uint8_t fd __attribute__((unused)))
+{
+	uint16_t offset = TCP_CHECKSUM_L_P + 3;
+	
+	return tcpDataCallback((char*)&buf[offset], BUFFER_SIZE - offset, client_tcp_reused() != 0);
+}
+
+/**
+*
+* @brief TCP client result callback
+*
+* @param fd file descriptor of the request
+* @param statuscode 0: data available | 3: connection reset
+* @param datapos start of the data in the packet buffer
+* @param len length of the data
+*
+* @return 1: close the connection | 0: keep it open
+*
+*/
+static uint8_t Ethernet_TCPResultCallback(uint8_t fd __attribute__((unused)), uint8_t statuscode, uint16_t datapos, uint16_t len)
+{
+	if(statuscode == 0 && tcpAnswerCallback((char*)&buf[datapos], len))
+	{
+		requestResult = ETHERNET_REQUEST_OK;
+		return 0;
+	}
+	
+	requestResult = ETHERNET_REQUEST_FAILED;
+	return 1;
+}
+
+/**
+*
+* @brief Send TCP request
+*
+* Raw request/answer exchange with the TCP client of the stack. The data is generated
+* by a callback directly in the packet buffer. With keep-alive (Ethernet_SetKeepAlive)
+* the connection stays open, the callback gets reused = true if the data is sent on
+* an open connection and false for the first data after the connection setup.
+* The answer callback checks the first data packet of the answer, the connection is
+* closed if it returns false.
+*
+* @param ip target ip (NULL: ip of the last DNS lookup)
+* @param port target port
+* @param dataCallback data generator
+* @param answerCallback answer check
+*
+* @return true: answer accepted | false: answer rejected, connection reset or timeout
+*
+*/
+bool Ethernet_SendTCP(uint8_t *ip, uint16_t port, uint16_t (*dataCallback)(char *data, uint16_t size, bool reused), bool (*answerCallback)(char *data, uint16_t length))
+{
+	uint8_t *target = (ip != NULL) ? ip : destIP;
+	
+	bufferBusy = true;
+	
+	uint8_t *mac = Ethernet_TargetMac(target);
+	
+	if(mac == NULL)
+	{
+		bufferBusy = false;
+		return false;
+	}
+	
+	tcpDataCallback = dataCallback;
+	tcpAnswerCallback = answerCallback;
+	requestResult = ETHERNET_REQUEST_PENDING;
+	
+	client_tcp_req(&Ethernet_TCPResultCallback, &Ethernet_TCPFillCallback, port, target, mac);
+	
+	bool success = Ethernet_WaitRequest();
+	
+	bufferBusy = false;
+	
+	return success;
+}
+
+/**
+*
+* @brief Accept the answer of the DNS server
+*
+* The address is used until the next lookup. The refresh is scheduled at 3/4 of
+* the TTL (limited to ETHERNET_DNS_TTL_MIN...ETHERNET_DNS_TTL_MAX).
+*
+* @return void
+*/
+static void Ethernet_DNSAccept(void)
+{
+	uint32_t ttl = dnslkup_get_ttl();
+	
+	if(ttl < ETHERNET_DNS_TTL_MIN)
+	ttl = ETHERNET_DNS_TTL_MIN;
+	
+	if(ttl > ETHERNET_DNS_TTL_MAX)
+	ttl = ETHERNET_DNS_TTL_MAX;
+	
+	dnslkup_get_ip(destIP);
+	dnsRefresh = Timebase_Millis() + ttl * 750;
+	dns_state = dnsStateHaveAnswer;
+}
+
+/**
+*
+* @brief Background DNS refresh
+*
+* Send a new request for the host of Ethernet_DNSLookup(), if the refresh time is
+* reached, and take over the answer. Until then (and if the DNS server doesn't
+* answer) the last address stays in use, so the uploads never wait for the DNS.
+*
+* @note uses the packet buffer, call only if it is not busy
+*
+* @return void
+*/
+static void Ethernet_DNSRefresh(void)
+{
+	uint32_t now = Timebase_Millis();
+	
+	if(dns_state == dnsStateRefreshSent)
+	{
+		if(dnslkup_haveanswer())
+		{
+			Ethernet_DNSAccept();
+			return;
+		}
+		
+		// no answer yet: send the request again after ETHERNET_DNS_RETRY
+		if(now - dnsRequestTime < ETHERNET_DNS_RETRY)
+		return;
+	}
+	else if(dns_state != dnsStateHaveAnswer || (int32_t)(now - dnsRefresh) < 0)
+	{
+		return;
+	}
+	
+	// the DNS server is reached over the gateway
+	uint8_t *mac = arp_cache_nexthop(deviceGw);
+	
+	if(mac == NULL || !enc28j60linkup())
 	return;
+	
+	dnsRequestTime = now;
+	dns_state = dnsStateRefreshSent;
+	dnslkup_request(buf, dnsHost, mac);
 }
 
 /**
 * @brief DNS lookup function
 *
-* @param host hostname (eg. api.thingspeak.com)
+* Blocking lookup of the target host (the request is repeated every ETHERNET_DNS_RETRY ms).
+* Afterwards the address is refreshed in the background by Ethernet_Poll().
+*
+* @param host hostname (eg. api.thingspeak.com), has to stay valid for the refresh
 *
 * @return void
 */
@@ -313,53 +715,44 @@ void Ethernet_DNSLookup(const char* host)
 {
 	uint16_t dat_p, plen;
 	
-	uint8_t dns_success = 0;
-	while(!dns_success)
+	bufferBusy = true;
+	
+	dnsHost = host;
+	dns_state = dnsStateIdle;
+	
+	while(dns_state != dnsStateHaveAnswer)
 	{
-		plen = enc28j60PacketReceive(BUFFER_SIZE, buf);		// read packet buffer
+		Scheduler_Yield();	// background tasks (sampling)
+		
+		plen = Ethernet_Receive();		// read packet buffer (only if signaled)
 		dat_p = packetloop_arp_icmp_tcp(buf, plen);			// receive ping
 		
 		// packets available?
 		if(plen == 0)
 		{
-			// Process Arp and DNS
-			if(gwArpState == 0)
-			{
-				// Lookup mac address of the gateway
-				get_mac_with_arp(deviceGw, TRANS_NUM_GWMAC, &arpresolverResultCallback);
-				gwArpState = 1;
-			}
-			
-			if(get_mac_with_arp_wait() == 0 && gwArpState == 1)
-			{
-				// Gateway mac address available
-				gwArpState = 2;
-			}
-			
-			if(dns_state == dnsStateIdle && gwArpState == 2)
+			if(dns_state == dnsStateIdle)
 			{
+				// mac address of the gateway (arp request until known)
+				uint8_t *mac = arp_cache_nexthop(deviceGw);
+				
 				// network connection etablished?
-				if(!enc28j60linkup())
+				if(mac == NULL || !enc28j60linkup())
 				continue;
 				
 				dns_state = dnsStateRequestSent;
-				dnslkup_request(buf, host, gwmac); // target host dns lookup
+				dnsRequestTime = Timebase_Millis();
+				dnslkup_request(buf, host, mac); // target host dns lookup
 				continue;
 			}
 			
 			if(dns_state == dnsStateRequestSent && dnslkup_haveanswer())
 			{
-				dns_state = dnsStateHaveAnswer;
-				dnslkup_get_ip(destIP);
-				startWebClient = 1; // controller ready to send
-				dns_success = 1;	// dns lookup successfull
+				Ethernet_DNSAccept();
 			}
-			
-			if(dns_state != dnsStateHaveAnswer)
+			else if(dns_state == dnsStateRequestSent && Timebase_Millis() - dnsRequestTime >= ETHERNET_DNS_RETRY)
 			{
-				// retry after dns lookup failed
-				_delay_ms(2000);
-				continue;
+				// dns lookup failed, send the request again
+				dns_state = dnsStateIdle;
 			}
 		}
 		
@@ -371,4 +764,80 @@ void Ethernet_DNSLookup(const char* host)
 			continue;
 		}
 	}
-}
\ No newline at end of file
+	
+	bufferBusy = false;
+}
+
+/**
+*
+* @brief Persistent HTTP connection
+*
+* The TCP connection to the target stays open between the uploads. If the
+* server closed it, the next request opens a new connection.
+*
+* @param enable true: keep-alive | false: new connection for every request
+*
+* @return void
+*/
+void Ethernet_SetKeepAlive(bool enable)
+{
+	client_tcp_keepalive(enable ? 1 : 0);
+}
+
+/**
+*
+* @brief Network poll hook
+*
+* Process received packets (ARP, ping, late TCP packets) while no request is active
+* and refresh the DNS address in the background.
+* Max. ETHERNET_POLL_MAX_PACKETS packets are processed per call, so the RX buffer of
+* the controller is drained without blocking the caller for a long time.
+*
+* @return void
+*/
+void Ethernet_Poll(void)
+{
+	uint16_t plen, dat_p;
+	
+	// the blocking requests process the packets themselves
+	if(!linkReady || bufferBusy)
+	return;
+	
+	for(uint8_t i = 0; i < ETHERNET_POLL_MAX_PACKETS; i++)
+	{
+		plen = Ethernet_Receive();
+		if(plen == 0)
+		break;
+		
+		dat_p = packetloop_arp_icmp_tcp(buf, plen);
+		
+		if(dat_p == 0)
+		udp_client_check_for_dns_answer(buf, plen);
+	}
+	
+	Ethernet_DNSRefresh();
+}
+
+/**
+*
+* @brief Network task
+*
+* Scheduler task, calls Ethernet_Poll() every ETHERNET_POLL_PERIOD. Once per second
+* the ARP cache is aged and the timeouts of the TCP client are checked (also while
+* a blocking request is active).
+*
+* @return void
+*/
+void Ethernet_PollTask(void)
+{
+	uint32_t now = Timebase_Millis();
+	
+	if(linkReady && now - stackLastTick >= 1000)
+	{
+		stackLastTick = now;
+		arp_cache_tick();
+		client_tcp_tick();
+	}
+	
+	Ethernet_Poll();
+}
@@ -38,14 +38,40 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define ETHERNET_POLL_MAX_PACKETS	2	/**< max. packets processed per Ethernet_Poll() call	*/
+#define ETHERNET_POLL_PERIOD		2	/**< period of the network task in ms					*/
+#define ETHERNET_RX_FALLBACK		100	/**< read the packet counter without interrupt after ms	*/
+#define ETHERNET_UDP_SRC_PORT		4601	/**< source port of the UDP datagrams					*/
+#define ETHERNET_ARP_TIMEOUT		3000	/**< max. wait for the MAC address of a target in ms	*/
+#define ETHERNET_REQUEST_TIMEOUT	60000UL	/**< max. wait for the end of a TCP request in ms (> all retries of the stack)	*/
+#define ETHERNET_DNS_RETRY			2000	/**< repeat an unanswered DNS request after ms			*/
+#define ETHERNET_DNS_TTL_MIN		30		/**< min. lifetime of a DNS address in s				*/
+#define ETHERNET_DNS_TTL_MAX		86400UL	/**< max. lifetime of a DNS address in s				*/
+
+#define ETHERNET_INT_DDR			DDRD	/**< INT pin of the ENC28J60 (INT0)				*/
+#define ETHERNET_INT_PORT			PORTD
+#define ETHERNET_INT_PIN			PD2
+
 void Ethernet_InitDHCP();
 
 void Ethernet_InitStatic();
 
 void Ethernet_ReadNetworkConfig(uint8_t* ip, uint8_t* gateway, uint8_t* mask);
 
-void Ethernet_SendGET_p(bool useIP, char* value, const char* requestUrl, uint8_t* ip, const char* host);
+bool Ethernet_SendGET_p(bool useIP, const char* requestUrl, uint8_t* ip, const char* host, uint16_t (*queryCallback)(char *query, uint16_t size));
+
+bool Ethernet_SendPOST_p(bool useIP, const char* requestUrl, uint8_t* ip, const char* host, uint16_t (*bodyCallback)(char *body, uint16_t size));
+
+bool Ethernet_SendUDP(uint8_t *ip, uint16_t port, uint16_t (*dataCallback)(char *data, uint16_t size));
+
+bool Ethernet_SendTCP(uint8_t *ip, uint16_t port, uint16_t (*dataCallback)(char *data, uint16_t size, bool reused), bool (*answerCallback)(char *data, uint16_t length));
 
 void Ethernet_DNSLookup(const char* host);
 
+void Ethernet_SetKeepAlive(bool enable);
+
+void Ethernet_Poll(void);
+
+void Ethernet_PollTask(void);
+
 #endif /* ETHERNET_H_ */
\ No newline at end of file
@@ -18,6 +18,12 @@
 
 #define WWW_client
 
+// entries of the arp cache (14 byte RAM each)
+#define ARP_CACHE_SIZE 4
+
+// raw tcp client (client_tcp_req), used by the MQTT publisher
+#define TCP_client
+
 // functions to decode cgi-form data
 #undef FROMDECODE_webserv_help
 
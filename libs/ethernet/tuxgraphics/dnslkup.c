@@ -27,6 +27,7 @@ static uint8_t dnstid_l=0; // a counter for transaction ID
 static uint8_t dnsip[4]={8,8,8,8}; // the google public DNS, don't change unless there is a real need
 static uint8_t haveDNSanswer=0;
 static uint8_t dns_answerip[4];
+static uint32_t dns_answerttl=0; // TTL of the A record in seconds
 static uint8_t dns_ansError=0;
 
 
@@ -47,6 +48,12 @@ void dnslkup_get_ip(uint8_t *ip)
         while(i<4){ip[i]=dns_answerip[i];i++;}
 }
 
+// TTL in seconds of the address returned by dnslkup_get_ip
+uint32_t dnslkup_get_ttl(void)
+{
+        return(dns_answerttl);
+}
+
 // Determine if the string is a hostname or an IP address
 // A valid IP is e.g. "10.0.11.22"
 uint8_t string_is_ipv4(const char *str){
@@ -209,6 +216,8 @@ ChecNextResp:
                 dns_ansError=2; // not IPv4
                 return(0);
         }
+        // type(2) class(2) TTL(4) data length(2)
+        dns_answerttl=((uint32_t)buf[UDP_DATA_P+i+4]<<24)|((uint32_t)buf[UDP_DATA_P+i+5]<<16)|((uint16_t)buf[UDP_DATA_P+i+6]<<8)|buf[UDP_DATA_P+i+7];
         i+=10;
         j=0;
         while(j<4){
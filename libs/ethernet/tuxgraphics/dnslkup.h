@@ -34,6 +34,8 @@ uint8_t udp_client_check_for_dns_answer(uint8_t *buf,uint16_t plen);
 // returns the host IP of the name that we looked up if dnslkup_haveanswer did return 1
 // ip is the return value
 extern void dnslkup_get_ip(uint8_t *ip);
+// returns the TTL (seconds) of the IP of dnslkup_get_ip
+extern uint32_t dnslkup_get_ttl(void);
 // Determine if the string is a hostname or an IP address
 // A valid IP is e.g. "10.10.11.22"
 // This function wants a prog_char (not a normal string)
@@ -50,6 +50,21 @@ static uint8_t tcp_otherside_ip[4];
 static uint8_t tcp_dst_mac[6]; // normally the gateway via which we want to send
 static uint8_t tcp_client_state=0;
 static uint16_t tcp_client_port=0;
+// persistent connection (keep-alive): the connection stays open after the
+// answer and the next request to the same ip/port is sent on it.
+// tcp_client_state 6 = send the request on the open connection.
+static uint8_t tcp_client_keepalive=0;
+static uint8_t tcp_client_reused=0; // request was sent on an open connection
+static uint8_t tcp_client_seqack[8]; // our next seq and the ack of the last packet we sent
+static uint8_t tcp_client_src_port_l; // lower byte of the src port of the open connection
+// timeouts in seconds (counted by client_tcp_tick):
+#define TCP_CLIENT_ACK_TIMEOUT 3 // syn-ack, ack of our data, sending (link down)
+#define TCP_CLIENT_ANSWER_TIMEOUT 10 // answer after the ack of our data
+#define TCP_CLIENT_RETRIES 2 // the request is repeated on a new connection
+static uint8_t tcp_client_acked=0; // the server has acknowledged our data
+static uint8_t tcp_client_phase=0; // state and acked at the last tick
+static uint8_t tcp_client_timer=0; // seconds in the current phase
+static uint8_t tcp_client_retries=0;
 // This function will be called if we ever get a result back from the
 // TCP connection to the sever:
 // close_connection= your_client_tcp_result_callback(uint8_t fd, uint8_t statuscode,uint16_t data_start_pos_in_buf, uint16_t len_of_data){...your code}
@@ -63,12 +78,15 @@ static uint16_t (*client_tcp_datafill_callback)(uint8_t);
 
 #if defined (WWW_client)
 // WWW_client uses TCP_client
+#ifndef TCP_client
 #define TCP_client 1
+#endif
 static uint8_t www_fd=0;
-static enum { method_GET=0, method_POST=1, method_PUT=2 } http_method = method_GET; // 0 = get, 1 = post, 2 = put
+static enum { method_GET=0, method_POST=1, method_PUT=2, method_POST_FILL=3, method_GET_FILL=4 } http_method = method_GET; // 0 = get, 1 = post, 2 = put, 3 = post with body fill callback, 4 = get with url fill callback
 static void (*client_browser_callback)(uint8_t,uint16_t,uint16_t); // the fields are: uint8_t webstatuscode,uint16_t datapos,uint16_t len; webstatuscode==0 means 2xx was the answer from the web server; datapos is start of http data and len the the length of that data
 static const prog_char *client_additionalheaderline;
 static char *client_postval;
+static uint16_t (*client_postfill_callback)(uint8_t *buf,uint16_t pos); // body of method_POST_FILL, url varpart of method_GET_FILL
 static const prog_char *client_urlbuf;
 static const char *client_urlbuf_var;
 static const char *client_hoststr;
@@ -87,6 +105,27 @@ static uint8_t arp_reference_number=0;
 #define WGW_INITIAL_ARP 1
 #define WGW_HAVE_MAC 2
 #define WGW_ACCEPT_ARP_REPLY 8
+// arp cache, the age is counted in seconds by arp_cache_tick():
+#ifndef ARP_CACHE_SIZE
+#define ARP_CACHE_SIZE 4
+#endif
+#define ARP_CACHE_REFRESH 240 // ask again if the entry is still used
+#define ARP_CACHE_TIMEOUT 300 // forget the entry without answer
+#define ARP_CACHE_PENDING_TIMEOUT 10 // give up an unanswered request
+#define ARP_CACHE_FREE 0
+#define ARP_CACHE_PENDING 1 // request sent, no answer yet
+#define ARP_CACHE_VALID 2
+struct arp_cache_entry{
+        uint8_t ip[4];
+        uint8_t mac[6];
+        uint8_t state;
+        uint8_t flags; // ARP_CACHE_F_...
+        uint16_t age; // seconds since the last answer or the first request
+};
+#define ARP_CACHE_F_REQUEST 1 // send a request in the packet loop
+#define ARP_CACHE_F_USED 2 // used since the last refresh
+static struct arp_cache_entry arp_cache[ARP_CACHE_SIZE];
+static uint8_t gwip[4]={0,0,0,0};
 #endif
 
 #ifdef WWW_server
@@ -190,6 +229,11 @@ void client_ifconfig(uint8_t *ip,uint8_t *netmask)
         }
 }
 
+void client_set_gwip(uint8_t *gwipaddr)
+{
+        memcpy(gwip,gwipaddr,4);
+}
+
 // returns 1 if destip must be routed via the GW. Returns 0 if destip is on the local LAN
 uint8_t route_via_gw(uint8_t *destip)
 {
@@ -1007,6 +1051,101 @@ void client_arp_whohas(uint8_t *buf,uint8_t *ip_we_search)
         enc28j60PacketSend(0x2a,buf);
 }
 
+static struct arp_cache_entry *arp_cache_find(const uint8_t *ip)
+{
+        uint8_t i=0;
+        while(i<ARP_CACHE_SIZE){
+                if (arp_cache[i].state!=ARP_CACHE_FREE && memcmp(arp_cache[i].ip,ip,4)==0){
+                        return(&arp_cache[i]);
+                }
+                i++;
+        }
+        return(0);
+}
+
+// store the mac address of an arp packet if we have an entry for the ip
+static void arp_cache_update(const uint8_t *ip,const uint8_t *mac)
+{
+        struct arp_cache_entry *e;
+        e=arp_cache_find(ip);
+        if (e){
+                memcpy(e->mac,mac,6);
+                e->state=ARP_CACHE_VALID;
+                e->flags&=~ARP_CACHE_F_REQUEST;
+                e->age=0;
+        }
+}
+
+// Returns the mac address of the next hop to destip (destip itself on the
+// LAN, otherwise the gateway of client_set_gwip) or 0 if the address is
+// not known yet. In that case an arp request is sent in the packet loop,
+// just call this function again later. Known entries are refreshed in the
+// background, so this does never block for a known host.
+uint8_t *arp_cache_nexthop(uint8_t *destip)
+{
+        struct arp_cache_entry *e;
+        uint8_t i=0;
+        if (route_via_gw(destip)){
+                destip=gwip;
+        }
+        e=arp_cache_find(destip);
+        if (e){
+                e->flags|=ARP_CACHE_F_USED;
+                if (e->state==ARP_CACHE_VALID){
+                        return(e->mac);
+                }
+                return(0);
+        }
+        // new entry: a free one or the oldest
+        e=&arp_cache[0];
+        while(i<ARP_CACHE_SIZE){
+                if (arp_cache[i].state==ARP_CACHE_FREE){
+                        e=&arp_cache[i];
+                        break;
+                }
+                if (arp_cache[i].age>e->age){
+                        e=&arp_cache[i];
+                }
+                i++;
+        }
+        memcpy(e->ip,destip,4);
+        e->state=ARP_CACHE_PENDING;
+        e->flags=ARP_CACHE_F_REQUEST|ARP_CACHE_F_USED;
+        e->age=0;
+        return(0);
+}
+
+// age the arp cache, call this function once per second
+void arp_cache_tick(void)
+{
+        uint8_t i=0;
+        struct arp_cache_entry *e;
+        while(i<ARP_CACHE_SIZE){
+                e=&arp_cache[i];
+                i++;
+                if (e->state==ARP_CACHE_FREE){
+                        continue;
+                }
+                if (e->age<0xffff) e->age++;
+                if (e->state==ARP_CACHE_PENDING){
+                        if (e->age>=ARP_CACHE_PENDING_TIMEOUT){
+                                e->state=ARP_CACHE_FREE;
+                        }else{
+                                e->flags|=ARP_CACHE_F_REQUEST; // repeat the request
+                        }
+                        continue;
+                }
+                if (e->age>=ARP_CACHE_TIMEOUT){
+                        e->state=ARP_CACHE_FREE;
+                        continue;
+                }
+                // refresh entries that are in use, the old mac stays valid until the answer
+                if (e->age>=ARP_CACHE_REFRESH && (e->flags & ARP_CACHE_F_USED)){
+                        e->flags=ARP_CACHE_F_REQUEST;
+                }
+        }
+}
+
 // return zero when current transaction is finished
 uint8_t get_mac_with_arp_wait(void)
 {
@@ -1101,6 +1240,53 @@ void tcp_client_syn(uint8_t *buf,uint8_t srcport,uint16_t dstport)
         // 4 is the tcp mss option:
         enc28j60PacketSend(IP_HEADER_LEN+TCP_HEADER_LEN_PLAIN+ETH_HEADER_LEN+4,buf);
 }
+
+// Send the data of the datafill callback on the open connection
+// (persistent connection, the seq/ack numbers are taken from the last
+// packet we sent on this connection)
+void tcp_client_send_data(uint8_t *buf)
+{
+        uint16_t len;
+        uint8_t i=0;
+        while(i<6){
+                buf[ETH_DST_MAC +i]=tcp_dst_mac[i];
+                buf[ETH_SRC_MAC +i]=macaddr[i];
+                i++;
+        }
+        buf[ETH_TYPE_H_P] = ETHTYPE_IP_H_V;
+        buf[ETH_TYPE_L_P] = ETHTYPE_IP_L_V;
+        fill_buf_p(&buf[IP_P],9,iphdr);
+        buf[IP_ID_L_P]=ipid; ipid++;
+        buf[IP_PROTO_P]=IP_PROTO_TCP_V;
+        i=0;
+        while(i<4){
+                buf[IP_DST_P+i]=tcp_otherside_ip[i];
+                buf[IP_SRC_P+i]=ipaddr[i];
+                i++;
+        }
+        buf[TCP_DST_PORT_H_P]=(tcp_client_port>>8)&0xff;
+        buf[TCP_DST_PORT_L_P]=(tcp_client_port&0xff);
+        buf[TCP_SRC_PORT_H_P]=TCPCLIENT_SRC_PORT_H;
+        buf[TCP_SRC_PORT_L_P]=tcp_client_src_port_l;
+        memcpy(&buf[TCP_SEQ_H_P],tcp_client_seqack,8);
+        buf[TCP_HEADER_LEN_P]=0x50; // 20 bytes, no options
+        buf[TCP_FLAGS_P]=TCP_FLAGS_ACK_V|TCP_FLAGS_PUSH_V;
+        buf[TCP_WIN_SIZE]=0x4;
+        buf[TCP_WIN_SIZE+1]=0;
+        // urgent pointer
+        buf[TCP_CHECKSUM_L_P+1]=0;
+        buf[TCP_CHECKSUM_L_P+2]=0;
+#if defined (WWW_client)
+        bufptr=buf;
+#endif
+        if (client_tcp_datafill_callback){
+                len=(*client_tcp_datafill_callback)((tcp_client_src_port_l>>5)&0x7);
+        }else{
+                len=0;
+        }
+        // sets the ip length and both checksums:
+        make_tcp_ack_with_data_noflags(buf,len);
+}
 #endif // TCP_client
 
 #if defined (TCP_client) 
@@ -1151,9 +1337,18 @@ uint8_t client_tcp_req(uint8_t (*result_callback)(uint8_t fd,uint8_t statuscode,
         uint8_t i=0;
         client_tcp_result_callback=result_callback;
         client_tcp_datafill_callback=datafill_callback;
-        while(i<4){tcp_otherside_ip[i]=dstip[i];i++;}
-        i=0;
         while(i<6){tcp_dst_mac[i]=dstmac[i];i++;}
+        tcp_client_acked=0;
+        tcp_client_retries=0;
+        if (tcp_client_keepalive && tcp_client_state==4 && tcp_client_port==port && memcmp(tcp_otherside_ip,dstip,4)==0){
+                // keep the fd, it is encoded in the src port of the open connection
+                tcp_client_state=6; // send on the open connection
+                return(tcp_fd);
+        }
+        // copy the ip after the check for an open connection
+        i=0;
+        while(i<4){tcp_otherside_ip[i]=dstip[i];i++;}
+        tcp_client_reused=0;
         tcp_client_port=port;
         tcp_client_state=1; // send a syn
         tcp_fd++;
@@ -1162,6 +1357,61 @@ uint8_t client_tcp_req(uint8_t (*result_callback)(uint8_t fd,uint8_t statuscode,
         }
         return(tcp_fd);
 }
+
+// Enable or disable persistent connections (on=1: the connection stays
+// open after the answer and is used again for the next request to the same
+// ip/port. If the server has closed it, a new connection is opened).
+void client_tcp_keepalive(uint8_t on)
+{
+        tcp_client_keepalive=on;
+}
+
+// Returns 1 if the data of the datafill callback is sent on a persistent
+// connection that was already open, 0 if it is the first data after the
+// connection setup (e.g. to send a protocol handshake first).
+uint8_t client_tcp_reused(void)
+{
+        return(tcp_client_reused);
+}
+
+// Call this function once per second. A request without progress in the
+// current phase (sending, syn-ack, ack of the data, answer) is repeated on
+// a new connection. After TCP_CLIENT_RETRIES the result callback is
+// executed with statuscode 4 (timeout).
+void client_tcp_tick(void)
+{
+        uint8_t phase,timeout;
+        if (tcp_client_state==0 || tcp_client_state==4 || tcp_client_state==5){
+                tcp_client_phase=0;
+                return;
+        }
+        phase=(tcp_client_state<<1)|tcp_client_acked;
+        if (phase!=tcp_client_phase){
+                tcp_client_phase=phase;
+                tcp_client_timer=0;
+        }
+        tcp_client_timer++;
+        timeout=TCP_CLIENT_ACK_TIMEOUT;
+        if (tcp_client_state==3 && tcp_client_acked){
+                timeout=TCP_CLIENT_ANSWER_TIMEOUT;
+        }
+        if (tcp_client_timer<timeout){
+                return;
+        }
+        tcp_client_timer=0;
+        if (tcp_client_retries<TCP_CLIENT_RETRIES){
+                // retransmission: syn and data on a new connection
+                tcp_client_retries++;
+                tcp_client_reused=0;
+                tcp_client_acked=0;
+                tcp_client_state=1;
+                return;
+        }
+        tcp_client_state=5;
+        if (client_tcp_result_callback){
+                (*client_tcp_result_callback)(tcp_fd,4,0,0);
+        }
+}
 #endif //  TCP_client
 
 #if defined (WWW_client) 
@@ -1169,19 +1419,25 @@ uint16_t www_client_internal_datafill_callback(uint8_t fd){
         char strbuf[5];
         uint16_t len=0;
         if (fd==www_fd){
-                if( http_method == method_GET )
+                if( http_method == method_GET || http_method == method_GET_FILL )
 				{
                         // GET
                         len=fill_tcp_data_p(bufptr,0,PSTR("GET "));
                         len=fill_tcp_data_p(bufptr,len,client_urlbuf);
-                        len=fill_tcp_data(bufptr,len,client_urlbuf_var);
+                        if( http_method == method_GET_FILL ){
+                                // the varpart is written by the callback directly into the packet
+                                len=(*client_postfill_callback)(bufptr,len);
+                        }else{
+                                len=fill_tcp_data(bufptr,len,client_urlbuf_var);
+                        }
                         // I would prefer http/1.0 but there is a funny
                         // bug in some apache webservers which causes
                         // them to send two packets (fragmented PDU)
                         // if we don't use HTTP/1.1 + Connection: close
 						len=fill_tcp_data_p(bufptr,len,PSTR(" HTTP/1.1\r\nHost: "));
                         len=fill_tcp_data(bufptr,len,client_hoststr);
-                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nUser-Agent: tgr/1.0\r\nConnection: close\r\n\r\n"));
+                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nUser-Agent: tgr/1.0\r\n"));
+                        len=fill_tcp_data_p(bufptr,len,tcp_client_keepalive?PSTR("Connection: keep-alive\r\n\r\n"):PSTR("Connection: close\r\n\r\n"));
 						
                 }
 				else if( http_method == method_POST )
@@ -1196,7 +1452,8 @@ uint16_t www_client_internal_datafill_callback(uint8_t fd){
                                 len=fill_tcp_data_p(bufptr,len,PSTR("\r\n"));
                                 len=fill_tcp_data_p(bufptr,len,client_additionalheaderline);
                         }
-                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nUser-Agent: tgr/1.1\r\nAccept: */*\r\nConnection: close\r\n"));
+                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nUser-Agent: tgr/1.1\r\nAccept: */*\r\n"));
+                        len=fill_tcp_data_p(bufptr,len,tcp_client_keepalive?PSTR("Connection: keep-alive\r\n"):PSTR("Connection: close\r\n"));
                         len=fill_tcp_data_p(bufptr,len,PSTR("Content-Length: "));
                         itoa(strlen(client_postval),strbuf,10);
                         len=fill_tcp_data(bufptr,len,strbuf);
@@ -1222,6 +1479,40 @@ uint16_t www_client_internal_datafill_callback(uint8_t fd){
 					len = fill_tcp_data_p( bufptr, len, PSTR( "\r\n\r\n" ));
 					len = fill_tcp_data( bufptr, len, client_postval );
                 }
+				else if( http_method == method_POST_FILL )
+				{
+                        // POST, body is written by the callback directly into the packet
+                        uint16_t lenpos,bodylen;
+                        uint8_t i;
+                        len=fill_tcp_data_p(bufptr,0,PSTR("POST "));
+                        len=fill_tcp_data_p(bufptr,len,client_urlbuf);
+                        // the varpart is optional (NULL with Ethernet_SendPOST_p)
+                        if (client_urlbuf_var){
+                                len=fill_tcp_data(bufptr,len,client_urlbuf_var);
+                        }
+                        len=fill_tcp_data_p(bufptr,len,PSTR(" HTTP/1.1\r\nHost: "));
+                        len=fill_tcp_data(bufptr,len,client_hoststr);
+                        if (client_additionalheaderline){
+                                len=fill_tcp_data_p(bufptr,len,PSTR("\r\n"));
+                                len=fill_tcp_data_p(bufptr,len,client_additionalheaderline);
+                        }
+                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nUser-Agent: tgr/1.1\r\nAccept: */*\r\n"));
+                        len=fill_tcp_data_p(bufptr,len,tcp_client_keepalive?PSTR("Connection: keep-alive\r\n"):PSTR("Connection: close\r\n"));
+                        // the length is unknown until the body is written:
+                        // reserve 5 digits, unused digits stay as leading whitespace
+                        len=fill_tcp_data_p(bufptr,len,PSTR("Content-Length:      "));
+                        lenpos=len;
+                        len=fill_tcp_data_p(bufptr,len,PSTR("\r\nContent-Type: application/x-www-form-urlencoded\r\n\r\n"));
+                        bodylen=len;
+                        len=(*client_postfill_callback)(bufptr,len);
+                        bodylen=len-bodylen;
+                        i=0;
+                        do{
+                                i++;
+                                bufptr[TCP_CHECKSUM_L_P+3+lenpos-i]='0'+(bodylen%10);
+                                bodylen/=10;
+                        }while(bodylen && i<5);
+                }
 
                 return(len);
         }
@@ -1246,6 +1537,9 @@ uint8_t www_client_internal_result_callback(uint8_t fd, uint8_t statuscode, uint
                         //(*client_browser_callback)(web_statuscode,((uint16_t)TCP_SRC_PORT_H_P+(bufptr[TCP_HEADER_LEN_P]>>4)*4),len_of_data);
                         (*client_browser_callback)(web_statuscode,datapos,len_of_data);
                 }
+        }else if (client_browser_callback){
+                // reset, timeout or no http answer
+                (*client_browser_callback)(0,0,0);
         }
         return(0);
 }
@@ -1281,6 +1575,24 @@ void client_browse_url(const prog_char *urlbuf,const char *urlbuf_varpart,const
         www_fd=client_tcp_req(&www_client_internal_result_callback,&www_client_internal_datafill_callback,80,dstip,dstmac);
 }
 
+// client web browser using http GET operation with a varpart that is
+// generated while the packet is assembled:
+// urlfill is called with the packet buffer and the position after urlbuf.
+// It must write the urlencoded varpart with the fill_tcp_data functions
+// and return the position after the varpart.
+// The string buffer to which hoststr is pointing must not be changed until
+// the callback is executed.
+void client_browse_url_fill(const prog_char *urlbuf,const char *hoststr,uint16_t (*urlfill)(uint8_t *buf,uint16_t pos),void (*callback)(uint8_t,uint16_t,uint16_t),uint8_t *dstip,uint8_t *dstmac)
+{
+        client_urlbuf=urlbuf;
+        client_urlbuf_var=NULL;
+        client_hoststr=hoststr;
+        client_postfill_callback=urlfill;
+        http_method = method_GET_FILL;
+        client_browser_callback=callback;
+        www_fd=client_tcp_req(&www_client_internal_result_callback,&www_client_internal_datafill_callback,80,dstip,dstmac);
+}
+
 // client web browser using http POST operation:
 // additionalheaderline must be set to NULL if not used.
 // The string buffers to which urlbuf_varpart and hoststr are pointing
@@ -1300,6 +1612,26 @@ void client_http_post(const prog_char *urlbuf, const char *urlbuf_varpart,const
         www_fd=client_tcp_req(&www_client_internal_result_callback,&www_client_internal_datafill_callback,80,dstip,dstmac);
 }
 
+// client web browser using http POST operation with a body that is
+// generated while the packet is assembled:
+// additionalheaderline must be set to NULL if not used.
+// postfill is called with the packet buffer and the start position of the
+// body. It must write the urlencoded body with the fill_tcp_data functions
+// and return the position after the body (max. 99999 bytes of body).
+// The string buffers to which urlbuf_varpart and hoststr are pointing
+// must not be changed until the callback is executed.
+void client_http_post_fill(const prog_char *urlbuf, const char *urlbuf_varpart,const char *hoststr, const prog_char *additionalheaderline,uint16_t (*postfill)(uint8_t *buf,uint16_t pos),void (*callback)(uint8_t,uint16_t,uint16_t),uint8_t *dstip,uint8_t *dstmac)
+{
+        client_urlbuf=urlbuf;
+        client_hoststr=hoststr;
+        client_urlbuf_var=urlbuf_varpart;
+        client_additionalheaderline=additionalheaderline;
+        client_postfill_callback=postfill;
+        http_method = method_POST_FILL;
+        client_browser_callback=callback;
+        www_fd=client_tcp_req(&www_client_internal_result_callback,&www_client_internal_datafill_callback,80,dstip,dstmac);
+}
+
 // client web browser using http PUT operation:
 // additionalheaderline must be set to NULL if not used.
 // The string buffers to which urlbuf_varpart and hoststr are pointing
@@ -1367,6 +1699,16 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                         arp_delaycnt=0; // this is like a timer, not so precise but good enough, it wraps in about 2 sec
                 }
                 arp_delaycnt++;
+                // one request of the arp cache per call (len is misused as index):
+                len=0;
+                while(len<ARP_CACHE_SIZE){
+                        if ((arp_cache[len].flags & ARP_CACHE_F_REQUEST) && enc28j60linkup()){
+                                arp_cache[len].flags&=~ARP_CACHE_F_REQUEST;
+                                client_arp_whohas(buf,arp_cache[len].ip);
+                                break;
+                        }
+                        len++;
+                }
 #if defined (TCP_client)
                 if (tcp_client_state==1 && enc28j60linkup()){ // send a syn
                         tcp_client_state=2;
@@ -1376,6 +1718,11 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                         // from the server:
                         tcp_client_syn(buf,((tcp_fd<<5) | (0x1f & tcpclient_src_port_l)),tcp_client_port);
                 }
+                if (tcp_client_state==6 && enc28j60linkup()){ // send on the open connection
+                        tcp_client_state=3;
+                        tcp_client_reused=1;
+                        tcp_client_send_data(buf);
+                }
 #endif
                 return(0);
         }
@@ -1384,6 +1731,10 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
         // verify the mac address by sending it to 
         // a unicast address.
         if(eth_type_is_arp_and_my_ip(buf,plen)){
+#ifdef ARP_MAC_resolver_client
+                // requests and replies of known hosts update the cache
+                arp_cache_update(&buf[ETH_ARP_SRC_IP_P],&buf[ETH_ARP_SRC_MAC_P]);
+#endif
                 if (buf[ETH_ARP_OPCODE_L_P]==ETH_ARP_OPCODE_REQ_L_V){
                         // is it an arp request 
                         make_arp_answer_from_request(buf);
@@ -1427,6 +1778,13 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                 }
                 // if we get a reset:
                 if (buf[TCP_FLAGS_P] & TCP_FLAGS_RST_V){
+                        if (tcp_client_reused && tcp_client_state==3){
+                                // the server has closed the persistent connection
+                                // meanwhile: open a new one and send the request again
+                                tcp_client_reused=0;
+                                tcp_client_state=1;
+                                return(0);
+                        }
                         if (client_tcp_result_callback){
                                 // parameters in client_tcp_result_callback: fd, status, buf_start, len
                                 (*client_tcp_result_callback)((buf[TCP_DST_PORT_L_P]>>5)&0x7,3,0,0);
@@ -1453,6 +1811,7 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                                         len=0;
                                 }
                                 tcp_client_state=3;
+                                tcp_client_acked=0;
                                 make_tcp_ack_with_data_noflags(buf,len);
                                 return(0);
                         }else{
@@ -1474,6 +1833,9 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                 }
                 // in tcp_client_state==3 we will normally first get an empty
                 // ack-packet and then a ack-packet with data.
+                if (tcp_client_state==3 && len==0 && (buf[TCP_FLAGS_P] & TCP_FLAGS_ACK_V)){
+                        tcp_client_acked=1; // now wait for the answer
+                }
                 if (tcp_client_state==3 && len>0){ 
                         // our first real data packet
                         tcp_client_state=4;
@@ -1502,6 +1864,10 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                 }
                 if (buf[TCP_FLAGS_P] & TCP_FLAGS_FIN_V){
                         make_tcp_ack_from_any(buf,len+1,TCP_FLAGS_PUSH_V|TCP_FLAGS_FIN_V);
+                        if (tcp_client_state!=4 && client_tcp_result_callback){
+                                // closed by the server before the answer
+                                (*client_tcp_result_callback)((buf[TCP_DST_PORT_L_P]>>5)&0x7,3,0,0);
+                        }
                         tcp_client_state=5; // connection terminated
                         return(0);
                 }
@@ -1510,6 +1876,11 @@ uint16_t packetloop_arp_icmp_tcp(uint8_t *buf,uint16_t plen)
                 // and we ack only once we have the full packet
                 if (len>0){
                         make_tcp_ack_from_any(buf,len,0);
+                        if (tcp_client_keepalive && tcp_client_state==4){
+                                // remember the connection for the next request
+                                memcpy(tcp_client_seqack,&buf[TCP_SEQ_H_P],8);
+                                tcp_client_src_port_l=buf[TCP_SRC_PORT_L_P];
+                        }
                 }
                 return(0);
         }
@@ -52,6 +52,14 @@ extern uint16_t fill_tcp_data_len(uint8_t *buf,uint16_t pos, const uint8_t *s, u
 extern void client_ifconfig(uint8_t *ip,uint8_t *netmask);
 // route_via_gw can be used decide if a packed needs to be routed via GW or can be found on the LAN:
 extern uint8_t route_via_gw(uint8_t *destip); // returns 1 if destip must be routed via the GW. Returns 0 if destip is on the local LAN
+extern void client_set_gwip(uint8_t *gwipaddr);
+//
+// ARP cache (ARP_CACHE_SIZE entries): arp_cache_nexthop returns the mac of the
+// next hop to destip (destip on the LAN, otherwise the gateway) or 0 while the
+// arp request is pending. Entries are refreshed before they expire, call
+// arp_cache_tick once per second.
+extern uint8_t *arp_cache_nexthop(uint8_t *destip);
+extern void arp_cache_tick(void);
 //
 // The get_mac_with_arp function can be used to find the MAC address of 
 // a host that is directly connected to the same LAN. It translates the IP address into
@@ -130,6 +138,18 @@ uint8_t get_mac_with_arp_wait(void); // checks current ongoing transaction, retu
 extern uint8_t client_tcp_req(uint8_t (*result_callback)(uint8_t fd,uint8_t statuscode,uint16_t data_start_pos_in_buf, uint16_t len_of_data),uint16_t (*datafill_callback)(uint8_t fd),uint16_t port,uint8_t *dstip,uint8_t *dstmac);
 #endif
 
+#if defined (WWW_client) || defined (TCP_client)
+// Persistent connections: on=1 keeps the connection open after the answer
+// (http: "Connection: keep-alive") and sends the next client_tcp_req to the
+// same ip/port on it. A connection closed by the server (FIN or RST) is
+// reopened automatically.
+extern void client_tcp_keepalive(uint8_t on);
+// 1: the datafill callback is called for an already open connection
+extern uint8_t client_tcp_reused(void);
+// timeouts and retransmission, call once per second (statuscode 4: timeout)
+extern void client_tcp_tick(void);
+#endif
+
 #ifdef WWW_client
 // ----- http get
 // The string buffers to which urlbuf_varpart and hoststr are pointing
@@ -143,6 +163,13 @@ extern void client_browse_url(const char *urlbuf, char *urlbuf_varpart, const ch
 // For possible status codes look at http://www.w3.org/Protocols/rfc2616/rfc2616-sec10.html
 // Basically 2xx (webstatuscode=2) is success and any 5xx, 4xx (webstatuscode>=4) is a failure.
 
+// ----- http get with url fill callback
+// Same as client_browse_url but the varpart of the url is written by urlfill
+// directly into the packet buffer (no RAM buffer needed for the query).
+// urlfill gets the packet buffer and the position after urlbuf and returns
+// the position after the varpart. Use the fill_tcp_data functions to write it.
+extern void client_browse_url_fill(const char *urlbuf,const char *hoststr,uint16_t (*urlfill)(uint8_t *buf,uint16_t pos),void (*callback)(uint8_t,uint16_t,uint16_t),uint8_t *dstip,uint8_t *dstmac);
+
 // ----- http post
 // client web browser using http POST operation:
 // additionalheaderline must be set to NULL if not used.
@@ -157,6 +184,12 @@ extern void client_http_post(const char *urlbuf, char *urlbuf_varpart,const char
 // webstatuscode is zero if there was no proper reply from the server (garbage message total communication failure, this is rare).
 // webstatuscode is otherwise the first digit of the http status code (e.g webstatuscode=2 for 200 OK);
 
+// ----- http post with body fill callback
+// Same as client_http_post but the body is written by postfill directly into
+// the packet buffer (no RAM buffer needed for the body). postfill gets the
+// packet buffer and the start position of the body and returns the position
+// after the body. Use the fill_tcp_data functions to write the body.
+extern void client_http_post_fill(const char *urlbuf, char *urlbuf_varpart,const char *hoststr, const char *additionalheaderline,uint16_t (*postfill)(uint8_t *buf,uint16_t pos),void (*callback)(uint8_t,uint16_t,uint16_t),uint8_t *dstip,uint8_t *dstmac);
 
 extern void client_http_put(const char *urlbuf, char *urlbuf_varpart,const char *hoststr, const char *additionalheaderline,char *postval,void (*callback)(uint8_t,uint16_t,uint16_t),uint8_t *dstip,uint8_t *dstmac);
 #endif
@@ -0,0 +1,237 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file filter.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Digital filter library
+ *
+ * Fixed-point filters for sensor samples, which can be chained per channel:
+ * moving average, single-pole IIR lowpass and median for spike rejection.
+ * The processing cost per sample is constant for every filter type.
+ *
+*/
+
+#include "filter.h"
+
+
+/**
+*
+* @brief Initialize a filter chain
+*
+* The configuration is an array of FILTER_MAX_STAGES entries. The chain ends at
+* the first entry of type FILTER_NONE. Invalid parameters are limited to the history size.
+*
+* @param chain Pointer of the filter chain
+* @param config Pointer of the stage configuration
+*
+* @return void
+*
+*/
+void Filter_Init(FilterChain *chain, const FilterConfig *config)
+{
+	chain->count = 0;
+	
+	for(uint8_t i = 0; i < FILTER_MAX_STAGES; i++)
+	{
+		if(config[i].type == FILTER_NONE)
+		break;
+		
+		FilterStage *stage = &chain->stage[chain->count++];
+		stage->type = config[i].type;
+		stage->param = config[i].param;
+		
+		// limit window to the history size
+		if(stage->type == FILTER_MOVING_AVERAGE && stage->param > 3)
+		stage->param = 3;
+		
+		if(stage->type == FILTER_MEDIAN)
+		stage->param = (stage->param >= 5) ? 5 : 3;
+		
+		if(stage->type == FILTER_IIR && stage->param > 15)
+		stage->param = 15;
+	}
+	
+	Filter_Reset(chain);
+	
+	return;
+}
+
+
+/**
+*
+* @brief Reset the state of a filter chain
+*
+* The next value initializes the history of all stages.
+*
+* @param chain Pointer of the filter chain
+*
+* @return void
+*
+*/
+void Filter_Reset(FilterChain *chain)
+{
+	for(uint8_t i = 0; i < chain->count; i++)
+	{
+		chain->stage[i].initialized = false;
+		chain->stage[i].index = 0;
+	}
+	
+	return;
+}
+
+
+/**
+*
+* @brief Moving average
+*
+* Running sum over a window of 2^n values. The division is a shift.
+*
+* @param stage Pointer of the filter stage
+* @param value input value
+*
+* @return filtered value
+*
+*/
+static uint16_t Filter_MovingAverage(FilterStage *stage, uint16_t value)
+{
+	uint8_t window = 1 << stage->param;
+	
+	if(!stage->initialized)
+	{
+		for(uint8_t i = 0; i < window; i++)
+		stage->history[i] = value;
+		
+		stage->acc = (int32_t)value << stage->param;
+		stage->initialized = true;
+	}
+	
+	stage->acc += (int32_t)value - stage->history[stage->index];
+	stage->history[stage->index] = value;
+	stage->index = (stage->index + 1) & (window - 1);
+	
+	return (uint16_t)(stage->acc >> stage->param);
+}
+
+
+/**
+*
+* @brief Single-pole IIR lowpass
+*
+* y = y + (x - y) / 2^n, the state is stored with 8 fractional bits.
+*
+* @param stage Pointer of the filter stage
+* @param value input value
+*
+* @return filtered value
+*
+*/
+static uint16_t Filter_IIR(FilterStage *stage, uint16_t value)
+{
+	int32_t input = (int32_t)value << 8;
+	
+	if(!stage->initialized)
+	{
+		stage->acc = input;
+		stage->initialized = true;
+	}
+	
+	stage->acc += (input - stage->acc) >> stage->param;
+	
+	return (uint16_t)((stage->acc + 128) >> 8);	// round to integer
+}
+
+
+/**
+*
+* @brief Median
+*
+* Sort a copy of the last 3 or 5 values (insertion sort with fixed length) and
+* return the middle one. Single spikes are removed completely.
+*
+* @param stage Pointer of the filter stage
+* @param value input value
+*
+* @return filtered value
+*
+*/
+static uint16_t Filter_Median(FilterStage *stage, uint16_t value)
+{
+	uint8_t window = stage->param;
+	uint16_t sorted[5];
+	
+	if(!stage->initialized)
+	{
+		for(uint8_t i = 0; i < window; i++)
+		stage->history[i] = value;
+		
+		stage->initialized = true;
+	}
+	
+	stage->history[stage->index] = value;
+	if(++stage->index >= window) stage->index = 0;
+	
+	for(uint8_t i = 0; i < window; i++)
+	{
+		uint16_t v = stage->history[i];
+		uint8_t j = i;
+		
+		while(j > 0 && sorted[j - 1] > v)
+		{
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = v;
+	}
+	
+	return sorted[window / 2];
+}
+
+
+/**
+*
+* @brief Process a value by all stages of the filter chain
+*
+* @param chain Pointer of the filter chain
+* @param value input value (raw ADC value)
+*
+* @return filtered value
+*
+*/
+uint16_t Filter_Process(FilterChain *chain, uint16_t value)
+{
+	for(uint8_t i = 0; i < chain->count; i++)
+	{
+		FilterStage *stage = &chain->stage[i];
+		
+		switch(stage->type)
+		{
+			case FILTER_MOVING_AVERAGE: value = Filter_MovingAverage(stage, value); break;
+			case FILTER_IIR: value = Filter_IIR(stage, value); break;
+			case FILTER_MEDIAN: value = Filter_Median(stage, value); break;
+		}
+	}
+	
+	return value;
+}
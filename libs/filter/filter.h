@@ -0,0 +1,83 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file filter.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FILTER_MAX_STAGES		3		/**< max. count of filters in a chain					*/
+#define FILTER_HISTORY_SIZE		8		/**< history size (max. window of a filter)				*/
+
+#define FILTER_NONE				0		/**< no filter (end of a chain configuration)			*/
+#define FILTER_MOVING_AVERAGE	1		/**< moving average, param: window 2^n (n = 1...3)		*/
+#define FILTER_IIR				2		/**< single-pole IIR lowpass, param: y += (x-y) / 2^n	*/
+#define FILTER_MEDIAN			3		/**< median, param: window (3 or 5)						*/
+
+/**
+*
+* @brief Configuration of a filter stage
+*
+*/
+typedef struct _FilterConfig{
+	uint8_t type;		/**< filter type (FILTER_...)	*/
+	uint8_t param;		/**< filter parameter			*/
+}FilterConfig;
+
+/**
+*
+* @brief State of a filter stage
+*
+*/
+typedef struct _FilterStage{
+	uint8_t type;							/**< filter type (FILTER_...)						*/
+	uint8_t param;							/**< filter parameter								*/
+	uint8_t index;							/**< position in the history						*/
+	bool initialized;						/**< history filled with the first value			*/
+	int32_t acc;							/**< running sum (moving average) or state (IIR)	*/
+	uint16_t history[FILTER_HISTORY_SIZE];	/**< last input values								*/
+}FilterStage;
+
+/**
+*
+* @brief Chain of filter stages
+*
+*/
+typedef struct _FilterChain{
+	FilterStage stage[FILTER_MAX_STAGES];	/**< filter stages in processing order	*/
+	uint8_t count;							/**< count of used stages				*/
+}FilterChain;
+
+void Filter_Init(FilterChain *chain, const FilterConfig *config);
+
+void Filter_Reset(FilterChain *chain);
+
+uint16_t Filter_Process(FilterChain *chain, uint16_t value);
+
+#endif /* FILTER_H_ */
@@ -0,0 +1,222 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file mqtt.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief MQTT 3.1.1 packet encoding
+ *
+ * Minimal client side of MQTT 3.1.1: CONNECT (clean session, no will, no login),
+ * PUBLISH with QoS 0 and PINGREQ. The packets are written into a caller supplied
+ * buffer (e.g. the TCP data of the packet buffer), several packets can be
+ * placed one after another in one TCP segment.
+ *
+ * The library has no transport, see Ethernet_SendTCP().
+ *
+*/
+
+#include "mqtt.h"
+#include <string.h>
+
+#define MQTT_TYPE_CONNECT		0x10	/**< fixed header: CONNECT				*/
+#define MQTT_TYPE_CONNACK		0x20	/**< fixed header: CONNACK				*/
+#define MQTT_TYPE_PUBLISH		0x30	/**< fixed header: PUBLISH, QoS 0		*/
+#define MQTT_TYPE_PINGREQ		0xC0	/**< fixed header: PINGREQ				*/
+#define MQTT_TYPE_PINGRESP		0xD0	/**< fixed header: PINGRESP				*/
+
+#define MQTT_PROTOCOL_LEVEL		4		/**< protocol level of MQTT 3.1.1		*/
+#define MQTT_FLAG_CLEAN			0x02	/**< connect flag: clean session		*/
+
+/**
+*
+* @brief Write the fixed header
+*
+* @param buffer output buffer
+* @param type packet type and flags
+* @param remaining remaining length (variable header and payload)
+*
+* @return size of the fixed header (2...4)
+*
+*/
+static uint8_t MQTT_PutHeader(uint8_t *buffer, uint8_t type, uint16_t remaining)
+{
+	uint8_t length = 1;
+	
+	buffer[0] = type;
+	
+	// remaining length: 7 bit per byte, MSB set if more bytes follow
+	while(remaining >= 0x80)
+	{
+		buffer[length++] = (uint8_t)(remaining | 0x80);
+		remaining >>= 7;
+	}
+	
+	buffer[length++] = (uint8_t)remaining;
+	
+	return length;
+}
+
+/**
+*
+* @brief Size of the fixed header
+*
+* @param remaining remaining length
+*
+* @return size of the fixed header
+*
+*/
+static uint8_t MQTT_HeaderSize(uint16_t remaining)
+{
+	if(remaining < 0x80)
+	return 2;
+	
+	return (remaining < 0x4000) ? 3 : 4;
+}
+
+/**
+*
+* @brief Write a length prefixed string
+*
+* @param buffer output buffer
+* @param data string data
+* @param length length of the data
+*
+* @return count of written bytes
+*
+*/
+static uint16_t MQTT_PutString(uint8_t *buffer, const char *data, uint16_t length)
+{
+	buffer[0] = length >> 8;
+	buffer[1] = length & 0xFF;
+	memcpy(&buffer[2], data, length);
+	
+	return length + 2;
+}
+
+/**
+*
+* @brief Write a CONNECT packet
+*
+* @param buffer output buffer
+* @param size size of the buffer
+* @param clientId client identifier (unique at the broker)
+* @param keepAlive keep alive interval in seconds (0: disabled)
+*
+* @return size of the packet (0: buffer too small)
+*
+*/
+uint16_t MQTT_Connect(uint8_t *buffer, uint16_t size, const char *clientId, uint16_t keepAlive)
+{
+	uint16_t idLength = strlen(clientId);
+	uint16_t remaining = 10 + 2 + idLength;
+	uint16_t length = MQTT_HeaderSize(remaining) + remaining;
+	
+	if(length > size)
+	return 0;
+	
+	uint8_t *pos = buffer + MQTT_PutHeader(buffer, MQTT_TYPE_CONNECT, remaining);
+	
+	// variable header: protocol name, level, flags, keep alive
+	pos += MQTT_PutString(pos, "MQTT", 4);
+	*pos++ = MQTT_PROTOCOL_LEVEL;
+	*pos++ = MQTT_FLAG_CLEAN;
+	*pos++ = keepAlive >> 8;
+	*pos++ = keepAlive & 0xFF;
+	
+	// payload: client identifier
+	MQTT_PutString(pos, clientId, idLength);
+	
+	return length;
+}
+
+/**
+*
+* @brief Write a PUBLISH packet (QoS 0, no retain)
+*
+* @param buffer output buffer
+* @param size size of the buffer
+* @param topic topic name
+* @param payload message
+* @param payloadLength length of the message
+*
+* @return size of the packet (0: buffer too small)
+*
+*/
+uint16_t MQTT_Publish(uint8_t *buffer, uint16_t size, const char *topic, const char *payload, uint16_t payloadLength)
+{
+	uint16_t topicLength = strlen(topic);
+	uint16_t remaining = 2 + topicLength + payloadLength;
+	uint16_t length = MQTT_HeaderSize(remaining) + remaining;
+	
+	if(length > size)
+	return 0;
+	
+	uint8_t *pos = buffer + MQTT_PutHeader(buffer, MQTT_TYPE_PUBLISH, remaining);
+	
+	// QoS 0: no packet identifier
+	pos += MQTT_PutString(pos, topic, topicLength);
+	memcpy(pos, payload, payloadLength);
+	
+	return length;
+}
+
+/**
+*
+* @brief Write a PINGREQ packet
+*
+* @param buffer output buffer
+* @param size size of the buffer
+*
+* @return size of the packet (0: buffer too small)
+*
+*/
+uint16_t MQTT_PingReq(uint8_t *buffer, uint16_t size)
+{
+	if(size < MQTT_PINGREQ_SIZE)
+	return 0;
+	
+	return MQTT_PutHeader(buffer, MQTT_TYPE_PINGREQ, 0);
+}
+
+/**
+*
+* @brief Check the answer of the broker
+*
+* The first packet of the answer has to be a CONNACK (after CONNECT) or a PINGRESP.
+*
+* @param data received data
+* @param length length of the data
+*
+* @return MQTT_ANSWER_OK | MQTT_ANSWER_REFUSED | MQTT_ANSWER_INVALID
+*
+*/
+uint8_t MQTT_CheckAnswer(const uint8_t *data, uint16_t length)
+{
+	if(length >= 4 && data[0] == MQTT_TYPE_CONNACK && data[1] == 2)
+	return (data[3] == 0) ? MQTT_ANSWER_OK : MQTT_ANSWER_REFUSED;
+	
+	if(length >= 2 && data[0] == MQTT_TYPE_PINGRESP && data[1] == 0)
+	return MQTT_ANSWER_OK;
+	
+	return MQTT_ANSWER_INVALID;
+}
\ No newline at end of file
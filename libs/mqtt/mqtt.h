@@ -0,0 +1,48 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file mqtt.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef MQTT_H_
+#define MQTT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MQTT_PINGREQ_SIZE		2	/**< size of a PINGREQ packet				*/
+
+#define MQTT_ANSWER_OK			0	/**< CONNACK accepted or PINGRESP			*/
+#define MQTT_ANSWER_REFUSED		1	/**< CONNACK with an error code				*/
+#define MQTT_ANSWER_INVALID		2	/**< no CONNACK or PINGRESP in the data		*/
+
+uint16_t MQTT_Connect(uint8_t *buffer, uint16_t size, const char *clientId, uint16_t keepAlive);
+
+uint16_t MQTT_Publish(uint8_t *buffer, uint16_t size, const char *topic, const char *payload, uint16_t payloadLength);
+
+uint16_t MQTT_PingReq(uint8_t *buffer, uint16_t size);
+
+uint8_t MQTT_CheckAnswer(const uint8_t *data, uint16_t length);
+
+#endif /* MQTT_H_ */
\ No newline at end of file
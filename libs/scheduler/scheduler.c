@@ -0,0 +1,133 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file scheduler.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Cooperative yield hook
+ *
+ * Run-to-completion tasks with a timer (period in milliseconds on the timebase). The
+ * state machine of main.c stays as it is; the tasks run from its loops.
+ *
+ * The views and the network functions still wait in loops for user input or answers,
+ * every waiting loop calls Scheduler_Yield(). So the background tasks (sampling, packet
+ * processing) run within milliseconds in every state of the datalogger.
+ * Scheduler_Yield() is not reentrant: a task that waits itself does not run other tasks.
+ *
+*/
+
+#include "scheduler.h"
+#include "../timebase/timebase.h"
+
+/**
+*
+* @brief Task entry
+*
+*/
+typedef struct _Scheduler_Entry{
+	Scheduler_Task task;	/**< task function					*/
+	uint16_t period;		/**< timer period in ms (0: no timer)	*/
+	uint32_t next;			/**< next timer event (Timebase_Millis)	*/
+}Scheduler_Entry;
+
+static Scheduler_Entry tasks[SCHEDULER_MAX_TASKS];				/**< task table							*/
+static uint8_t taskCount = 0;									/**< count of registered tasks			*/
+
+static bool running = false;									/**< Scheduler_Yield() active			*/
+
+
+/**
+*
+* @brief Register a task
+*
+* @param task task function
+* @param period timer period in milliseconds (0: timer stopped)
+*
+* @return task id | -1: task table full
+*
+*/
+int8_t Scheduler_AddTask(Scheduler_Task task, uint16_t period)
+{
+	if(taskCount >= SCHEDULER_MAX_TASKS)
+	return -1;
+	
+	tasks[taskCount].task = task;
+	tasks[taskCount].period = period;
+	tasks[taskCount].next = Timebase_Millis() + period;
+	
+	return taskCount++;
+}
+
+/**
+*
+* @brief Change the timer period of a task
+*
+* @param id task id
+* @param period timer period in milliseconds (0: stop the timer)
+*
+* @return void
+*
+*/
+void Scheduler_SetPeriod(uint8_t id, uint16_t period)
+{
+	if(id >= taskCount)
+	return;
+	
+	tasks[id].period = period;
+	tasks[id].next = Timebase_Millis() + period;
+}
+
+/**
+*
+* @brief Run the pending tasks
+*
+* Every task with an expired timer runs once. A timer that is more than one period
+* behind is restarted, missed timer events are not repeated.
+*
+* @return void
+*
+*/
+void Scheduler_Yield(void)
+{
+	if(running)
+	return;
+	
+	running = true;
+	
+	uint32_t now = Timebase_Millis();
+	
+	for(uint8_t i = 0; i < taskCount; i++)
+	{
+		if(tasks[i].period == 0 || (int32_t)(now - tasks[i].next) < 0)
+		continue;
+		
+		tasks[i].next += tasks[i].period;
+		if((int32_t)(now - tasks[i].next) >= 0)
+		tasks[i].next = now + tasks[i].period;
+		
+		tasks[i].task();
+	}
+	
+	running = false;
+}
@@ -60,17 +60,42 @@
 #define ACMD41_CRC          0x00
 
 
+#define CMD12				12
+#define CMD12_ARG			0x00000000
+#define CMD12_CRC			0x00
+
+
 #define CMD17				17
 #define CMD17_CRC			0x00
 
 
+#define CMD18				18
+#define CMD18_CRC			0x00
+
+
+#define CMD24				24
+#define CMD24_CRC			0x00
+
+
+#define CMD25				25
+#define CMD25_CRC			0x00
+
+
+#define ACMD23				23
+#define ACMD23_CRC			0x00
+
+
 #define SD_READY				0x00
 #define SD_IN_IDLE_STATE		0x01
 #define SD_START_TOKEN          0xFE
+#define SD_MULTI_START_TOKEN	0xFC	/**< start token of a block in a multiple block write		*/
+#define SD_STOP_TRAN_TOKEN		0xFD	/**< end of a multiple block write							*/
 #define CMD0_MAX_ATTEMPTS       255
 #define CMD55_MAX_ATTEMPTS      255
 #define SD_R1_NO_ERROR(x)		x < 0x02
 #define SD_MAX_READ_ATTEMPTS	1563
+#define SD_MAX_WRITE_ATTEMPTS	65535	/**< busy polling after a write (about 450ms at F_CPU/16)	*/
+#define SD_DATA_ACCEPTED		0x05	/**< data response token: data accepted						*/
 
 
 #endif /* DEFINITIONS_H_ */
\ No newline at end of file
@@ -83,7 +83,11 @@ uint8_t getBootSectorData()
 	_sectorPerCluster = bpb->sectorPerCluster;
 	_reservedSectorCount = bpb->reservedSectorCount;
 	_rootCluster = bpb->rootCluster;
-	_firstDataSector = bpb->hiddenSectors + _reservedSectorCount + (bpb->numberofFATs * bpb->FATsize_F32);
+	_firstFATSector = bpb->hiddenSectors + _reservedSectorCount;
+	_FATSectors = bpb->FATsize_F32;
+	_numberOfFATs = bpb->numberofFATs;
+	_FSInfoSector = bpb->hiddenSectors + bpb->FSinfo;
+	_firstDataSector = _firstFATSector + (bpb->numberofFATs * bpb->FATsize_F32);
 	
 	dataSectors = bpb->totalSectors_F32 - bpb->reservedSectorCount - (bpb->numberofFATs * bpb->FATsize_F32);
 	_totalClusters = dataSectors / _sectorPerCluster;
@@ -205,3 +209,572 @@ char* readFile(char* filename)
 	
 	return "\0"; // no file found - return empty content
 }
+
+static uint16_t dirOffset;		/**< offset of the entry found by findDirEntry()	*/
+static uint32_t chainCluster;	/**< next cluster of the chain check	*/
+static uint32_t chainLast;		/**< last cluster of the checked file	*/
+
+/**
+*
+* @brief Check the FAT entries of one sector (callback of SDReadBlocks)
+*
+* The entries from chainCluster up to the end of the sector or chainLast have
+* to point to the following cluster.
+*
+* @param index index of the FAT sector in the read
+*
+* @return 0: continue | 1: chain not contiguous
+*
+*/
+static uint8_t checkChainSector(uint32_t index)
+{
+	uint32_t *entries = (uint32_t *)_SDBuffer;
+	
+	do{
+		if(chainCluster == chainLast)
+		return 0;
+		
+		if((entries[chainCluster & 0x7F] & 0x0FFFFFFF) != chainCluster + 1)
+		return 1;
+		
+		chainCluster++;
+		
+	}while((chainCluster & 0x7F) != 0);
+	
+	return 0;
+}
+
+/**
+*
+* @brief Search a file in the root directory
+*
+* Search the entries of the first root directory cluster. The sector of a
+* found entry stays in _SDBuffer, the offset of the entry is stored in dirOffset.
+*
+* @param fatName file name in FAT format (see convertFileName())
+* @param sector sector of the entry (file not found: sector of the first free entry)
+*
+* @return 0: file found | 1: file not found, free entry available | 2: directory full or read error
+*
+*/
+static uint8_t findDirEntry(char *fatName, uint32_t *sector)
+{
+	struct DirStructure *dir;
+	uint32_t freeSector = 0;
+	uint16_t freeOffset = 0;
+	uint8_t res, token;
+	
+	for(uint16_t s = 0; s < _sectorPerCluster; s++)
+	{
+		*sector = getFirstSector(_rootCluster) + s;
+		
+		res = SDReadBlock(*sector, &token);
+		if(!(SD_R1_NO_ERROR(res) && (token == SD_START_TOKEN)))
+		return 2;
+		
+		for(uint16_t i = 0; i < 512; i += 32)
+		{
+			dir = (struct DirStructure *)&_SDBuffer[i];
+			
+			// first free entry for a new file
+			if((dir->name[0] == EMPTY || dir->name[0] == DELETED) && freeSector == 0)
+			{
+				freeSector = *sector;
+				freeOffset = i;
+			}
+			
+			// end of the directory
+			if(dir->name[0] == EMPTY)
+			{
+				*sector = freeSector;
+				dirOffset = freeOffset;
+				return 1;
+			}
+			
+			if(dir->name[0] == DELETED || dir->attrib == ATTR_LONG_NAME || (dir->attrib & (ATTR_DIRECTORY | ATTR_VOLUME_ID)))
+			continue;
+			
+			if(memcmp(dir->name, fatName, 11) == 0)
+			{
+				dirOffset = i;
+				return 0;
+			}
+		}
+	}
+	
+	if(freeSector == 0)
+	return 2;
+	
+	*sector = freeSector;
+	dirOffset = freeOffset;
+	
+	return 1;
+}
+
+/**
+*
+* @brief Locate a contiguous file
+*
+* Search the file in the root directory and check its cluster chain in the FAT.
+* The sectors of a contiguous file can be written directly, the FAT and the
+* directory entry stay unchanged.
+*
+* @param fileName file with extension (converted to the FAT name)
+* @param firstSector first sector of the file
+* @param fileSize file size in bytes
+*
+* @return 0: file found | 1: file not found or read error | 2: clusters not contiguous
+*
+*/
+uint8_t getContiguousFile(char *fileName, uint32_t *firstSector, uint32_t *fileSize)
+{
+	struct DirStructure *dir;
+	uint32_t cluster, clusters, sector;
+	uint8_t res, token;
+	
+	convertFileName(fileName);
+	
+	if(findDirEntry(fileName, &sector) != 0)
+	return 1;
+	
+	dir = (struct DirStructure *)&_SDBuffer[dirOffset];
+	cluster = ( (uint32_t)dir->firstClusterHI << 16 | (uint32_t)dir->firstClusterLO);
+	*fileSize = dir->fileSize;
+	
+	if(cluster < 2)
+	return 1;
+	
+	*firstSector = getFirstSector(cluster);
+	
+	// every cluster has to point to the following one, the FAT sectors of the
+	// chain are read with one multiple block read
+	clusters = (*fileSize + (uint32_t)_sectorPerCluster * 512 - 1) / ((uint32_t)_sectorPerCluster * 512);
+	if(clusters < 2)
+	return 0;
+	
+	chainCluster = cluster;
+	chainLast = cluster + clusters - 1;
+	
+	res = SDReadBlocks(_firstFATSector + (cluster >> 7), ((chainLast - 1) >> 7) - (cluster >> 7) + 1, &token, &checkChainSector);
+	if(!(SD_R1_NO_ERROR(res) && (token == SD_START_TOKEN)))
+	return 1;
+	
+	return (chainCluster == chainLast) ? 0 : 2;
+}
+
+static uint32_t appendCluster = 0;		/**< last cluster of the append file (0: no cluster yet)	*/
+static uint32_t appendBytes = 0;		/**< bytes of the clusters in the chain of the append file	*/
+static uint16_t appendEntryOffset = 0;	/**< offset of the directory entry of the append file		*/
+static uint32_t freeHint = 2;			/**< start of the next free cluster search					*/
+static uint32_t scanCluster;			/**< next cluster of the free cluster search				*/
+static uint32_t scanEnd;				/**< end of the free cluster search							*/
+
+/**
+*
+* @brief Read a sector to _SDBuffer
+*
+* @param sector address of the sector
+*
+* @return 0: read succesfull | 1: read not succesfull
+*
+*/
+static uint8_t readSector(uint32_t sector)
+{
+	uint8_t res, token;
+	
+	res = SDReadBlock(sector, &token);
+	
+	return (SD_R1_NO_ERROR(res) && (token == SD_START_TOKEN)) ? 0 : 1;
+}
+
+/**
+*
+* @brief Write _SDBuffer to a sector
+*
+* @param sector address of the sector
+*
+* @return 0: write succesfull | 1: write not succesfull
+*
+*/
+static uint8_t writeSector(uint32_t sector)
+{
+	uint8_t res, token;
+	
+	res = SDWriteBlock(sector, &token);
+	
+	return (res == SD_READY && token == SD_DATA_ACCEPTED) ? 0 : 1;
+}
+
+/**
+*
+* @brief Set a FAT entry
+*
+* The entry is changed in every copy of the FAT, the upper 4 bits are kept.
+*
+* @param cluster cluster number of the entry
+* @param value next cluster or end of chain (0x0FFFFFFF)
+*
+* @return 0: entry written | 1: read/write error
+*
+*/
+static uint8_t setFATEntry(uint32_t cluster, uint32_t value)
+{
+	uint32_t *entry = &((uint32_t *)_SDBuffer)[cluster & 0x7F];
+	
+	for(uint8_t i = 0; i < _numberOfFATs; i++)
+	{
+		uint32_t sector = _firstFATSector + i * _FATSectors + (cluster >> 7);
+		
+		if(readSector(sector))
+		return 1;
+		
+		*entry = (*entry & 0xF0000000) | (value & 0x0FFFFFFF);
+		
+		if(writeSector(sector))
+		return 1;
+	}
+	
+	return 0;
+}
+
+/**
+*
+* @brief Search free entries in one FAT sector (callback of SDReadBlocks)
+*
+* @param index index of the FAT sector in the read
+*
+* @return 0: continue | 1: free cluster found or end of the search
+*
+*/
+static uint8_t scanFreeSector(uint32_t index)
+{
+	uint32_t *entries = (uint32_t *)_SDBuffer;
+	
+	do{
+		if(scanCluster >= scanEnd)
+		return 1;
+		
+		if((entries[scanCluster & 0x7F] & 0x0FFFFFFF) == 0)
+		return 1;
+		
+		scanCluster++;
+		
+	}while((scanCluster & 0x7F) != 0);
+	
+	return 0;
+}
+
+/**
+*
+* @brief Search a free cluster
+*
+* The search starts at the free-cluster hint and continues at the start of the
+* FAT, the FAT sectors are read with multiple block reads.
+*
+* @return free cluster | 0: no free cluster or read error
+*
+*/
+static uint32_t findFreeCluster(void)
+{
+	uint32_t start = freeHint;
+	uint32_t last = _totalClusters + 2;
+	uint8_t res, token;
+	
+	for(uint8_t pass = 0; pass < 2; pass++)
+	{
+		scanCluster = (pass == 0) ? start : 2;
+		scanEnd = (pass == 0) ? last : start;
+		
+		if(scanCluster >= scanEnd)
+		continue;
+		
+		res = SDReadBlocks(_firstFATSector + (scanCluster >> 7), ((scanEnd - 1) >> 7) - (scanCluster >> 7) + 1, &token, &scanFreeSector);
+		if(!(SD_R1_NO_ERROR(res) && (token == SD_START_TOKEN)))
+		return 0;
+		
+		if(scanCluster < scanEnd)
+		{
+			freeHint = scanCluster + 1;
+			return scanCluster;
+		}
+	}
+	
+	return 0;
+}
+
+/**
+*
+* @brief Add a cluster to the append file
+*
+* The new cluster is marked as end of the chain before it is linked, a power
+* loss leaves a lost cluster but no broken chain. The directory entry is updated
+* and the free cluster count of FSInfo is invalidated with the first allocation.
+*
+* @return 0: cluster added | 1: no free cluster or read/write error
+*
+*/
+static uint8_t allocateCluster(void)
+{
+	struct FSInfoStructure *fsInfo;
+	uint32_t cluster = findFreeCluster();
+	
+	if(cluster == 0)
+	return 1;
+	
+	if(setFATEntry(cluster, 0x0FFFFFFF))
+	return 1;
+	
+	if(appendCluster != 0)
+	{
+		if(setFATEntry(appendCluster, cluster))
+		return 1;
+	}
+	else
+	_appendStartCluster = cluster;
+	
+	appendCluster = cluster;
+	appendBytes += (uint32_t)_sectorPerCluster * 512;
+	
+	if(syncAppendFile())
+	return 1;
+	
+	// the free cluster count is recalculated by the next OS mount
+	if(!_freeClusterCountUpdated && readSector(_FSInfoSector) == 0)
+	{
+		fsInfo = (struct FSInfoStructure *)_SDBuffer;
+		if(fsInfo->leadSignature == 0x41615252 && fsInfo->structureSignature == 0x61417272)
+		{
+			fsInfo->freeClusterCount = 0xFFFFFFFF;
+			fsInfo->nextFreeCluster = freeHint;
+			
+			if(writeSector(_FSInfoSector) == 0)
+			_freeClusterCountUpdated = 1;
+		}
+	}
+	
+	return 0;
+}
+
+/**
+*
+* @brief Open a file for appending
+*
+* The file is created in the root directory, if it does not exist. The last
+* cluster of the file is searched once, the following appends need no FAT
+* access until a new cluster is needed.
+*
+* @param fileName file with extension (converted to the FAT name)
+*
+* @return 0: file opened | 1: read/write error or directory full | 2: broken cluster chain
+*
+*/
+uint8_t openAppendFile(char *fileName)
+{
+	struct DirStructure *dir;
+	struct FSInfoStructure *fsInfo;
+	uint32_t sector, clusters, fatSector, loaded = 0;
+	uint32_t clusterBytes = (uint32_t)_sectorPerCluster * 512;
+	uint8_t res;
+	
+	_appendFileLocation = 0;
+	_freeClusterCountUpdated = 0;
+	
+	convertFileName(fileName);
+	
+	res = findDirEntry(fileName, &sector);
+	if(res == 2)
+	return 1;
+	
+	dir = (struct DirStructure *)&_SDBuffer[dirOffset];
+	
+	// new empty file without cluster
+	if(res == 1)
+	{
+		if(readSector(sector))
+		return 1;
+		
+		memset(dir, 0, sizeof(struct DirStructure));
+		memcpy(dir->name, fileName, 11);
+		dir->attrib = ATTR_ARCHIVE;
+		
+		if(writeSector(sector))
+		return 1;
+	}
+	
+	_appendStartCluster = ( (uint32_t)dir->firstClusterHI << 16 | (uint32_t)dir->firstClusterLO);
+	_fileSize = dir->fileSize;
+	appendEntryOffset = dirOffset;
+	
+	// free-cluster hint of the file system
+	freeHint = 2;
+	if(readSector(_FSInfoSector) == 0)
+	{
+		fsInfo = (struct FSInfoStructure *)_SDBuffer;
+		if(fsInfo->leadSignature == 0x41615252 && fsInfo->nextFreeCluster >= 2 && fsInfo->nextFreeCluster < _totalClusters + 2)
+		freeHint = fsInfo->nextFreeCluster;
+	}
+	
+	// last cluster of the chain
+	appendCluster = _appendStartCluster;
+	clusters = (_fileSize + clusterBytes - 1) / clusterBytes;
+	appendBytes = clusters * clusterBytes;
+	
+	if(clusters > 0 && appendCluster < 2)
+	return 2;
+	
+	for(uint32_t i = 1; i < clusters; i++)
+	{
+		fatSector = _firstFATSector + (appendCluster >> 7);
+		if(fatSector != loaded)
+		{
+			if(readSector(fatSector))
+			return 1;
+			
+			loaded = fatSector;
+		}
+		
+		appendCluster = ((uint32_t *)_SDBuffer)[appendCluster & 0x7F] & 0x0FFFFFFF;
+		if(appendCluster < 2 || appendCluster >= _totalClusters + 2)
+		return 2;
+	}
+	
+	_appendFileLocation = sector;
+	
+	return 0;
+}
+
+/**
+*
+* @brief Append data to the open file
+*
+* A started sector is read and completed, new clusters are allocated from the
+* FAT. Consecutive sectors of a cluster are written with one multiple block write
+* (ACMD23 pre-erase, CMD25). The file size in the directory entry is updated with
+* syncAppendFile().
+*
+* @param data data to append
+* @param length count of bytes
+*
+* @return 0: data written | 1: no open file, card full or read/write error
+*
+*/
+uint8_t appendFile(const char *data, uint16_t length)
+{
+	uint32_t clusterBytes = (uint32_t)_sectorPerCluster * 512;
+	uint16_t offset, part, sectors, left, written;
+	uint8_t multi;
+	
+	if(_appendFileLocation == 0)
+	return 1;
+	
+	while(length > 0)
+	{
+		// first cluster of an empty file or last cluster full (a cluster allocated
+		// before a failed write is still part of the chain and used by the retry)
+		if(_fileSize >= appendBytes)
+		{
+			if(allocateCluster())
+			return 1;
+		}
+		
+		_appendFileSector = getFirstSector(appendCluster) + (_fileSize % clusterBytes) / 512;
+		offset = _fileSize % 512;
+		
+		// sectors of the data in the current cluster
+		sectors = ((uint32_t)offset + length + 511) / 512;
+		left = _sectorPerCluster - (_fileSize % clusterBytes) / 512;
+		if(sectors > left)
+		sectors = left;
+		
+		if(offset > 0)
+		{
+			if(readSector(_appendFileSector))
+			return 1;
+		}
+		else
+		memset((uint8_t *)_SDBuffer, 0, 512);
+		
+		// a rejected CMD25 falls back to single block writes
+		multi = (sectors > 1 && SDWriteMultiStart(_appendFileSector, sectors) == SD_READY);
+		written = 0;
+		
+		for(uint16_t i = 0; i < sectors; i++)
+		{
+			part = 512 - offset;
+			if(part > length)
+			part = length;
+			
+			memcpy((uint8_t *)&_SDBuffer[offset], data, part);
+			
+			if(multi)
+			{
+				if(SDWriteMultiBlock() != SD_DATA_ACCEPTED)
+				{
+					SDWriteMultiStop();
+					return 1;
+				}
+			}
+			else if(writeSector(_appendFileSector))
+			return 1;
+			
+			_appendFileSector++;
+			written += part;
+			data += part;
+			length -= part;
+			
+			// the following sector is new
+			offset = 0;
+			if(length > 0)
+			memset((uint8_t *)_SDBuffer, 0, 512);
+		}
+		
+		// the data counts after the card has programmed the last block
+		if(multi && SDWriteMultiStop() == SD_FAIL)
+		return 1;
+		
+		_fileSize += written;
+	}
+	
+	return 0;
+}
+
+/**
+*
+* @brief Write size and first cluster of the append file to its directory entry
+*
+* @return 0: entry written | 1: no open file or read/write error
+*
+*/
+uint8_t syncAppendFile(void)
+{
+	struct DirStructure *dir;
+	
+	if(_appendFileLocation == 0)
+	return 1;
+	
+	if(readSector(_appendFileLocation))
+	return 1;
+	
+	dir = (struct DirStructure *)&_SDBuffer[appendEntryOffset];
+	dir->firstClusterHI = (uint16_t)(_appendStartCluster >> 16);
+	dir->firstClusterLO = (uint16_t)_appendStartCluster;
+	dir->fileSize = _fileSize;
+	
+	return writeSector(_appendFileLocation);
+}
+
+/**
+*
+* @brief Close the append file
+*
+* @return 0: directory entry written | 1: no open file or read/write error
+*
+*/
+uint8_t closeAppendFile(void)
+{
+	uint8_t res = syncAppendFile();
+	
+	_appendFileLocation = 0;
+	
+	return res;
+}
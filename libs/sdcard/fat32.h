@@ -216,6 +216,10 @@ typedef struct _filePosition{
 
 
 volatile uint32_t _firstDataSector;		/**< address of the first data sector				*/
+volatile uint32_t _firstFATSector;		/**< address of the first sector of the FAT			*/
+volatile uint32_t _FATSectors;			/**< count of sectors per FAT						*/
+volatile uint8_t _numberOfFATs;			/**< count of FATs									*/
+volatile uint32_t _FSInfoSector;		/**< address of the FSInfo sector					*/
 volatile uint32_t _rootCluster;			/**< address of the root cluster					*/
 volatile uint32_t _totalClusters;		/**< count of all clusters							*/
 
@@ -250,5 +254,15 @@ uint8_t convertFileName(char* fileName);
 
 char* readFile(char*);
 
+uint8_t getContiguousFile(char *fileName, uint32_t *firstSector, uint32_t *fileSize);
+
+uint8_t openAppendFile(char *fileName);
+
+uint8_t appendFile(const char *data, uint16_t length);
+
+uint8_t syncAppendFile(void);
+
+uint8_t closeAppendFile(void);
+
 
 #endif /* FAT32_H_ */
\ No newline at end of file
@@ -328,6 +328,328 @@ uint8_t SDReadBlock(uint32_t addr, uint8_t *token)
 }
 
 
+/**
+*
+* @brief Wait until the SDcard is ready
+*
+* The SDcard holds the data line low while it programs a block.
+*
+* @note chip select has to be active
+*
+* @return SD_SUCCESS: ready | SD_FAIL: still busy after SD_MAX_WRITE_ATTEMPTS
+*
+*/
+static uint8_t SDWaitReady(void)
+{
+	uint16_t attempts = 0;
+	
+	while(SPI_transreceive(0xFF) == 0x00)
+	{
+		if(++attempts == SD_MAX_WRITE_ATTEMPTS)
+		return SD_FAIL;
+	}
+	
+	return SD_SUCCESS;
+}
+
+
+/**
+*
+* @brief Send a data packet
+*
+* Send _SDBuffer[] (sdcard.h) after the start token and wait until the SDcard
+* has programmed the block.
+*
+* @note chip select has to be active
+*
+* @param startToken SD_START_TOKEN (CMD24) or SD_MULTI_START_TOKEN (CMD25)
+*
+* @return data response: SD_DATA_ACCEPTED if the block was written
+*
+*/
+static uint8_t SDWriteData(uint8_t startToken)
+{
+	uint8_t read;
+	uint16_t attempts;
+	
+	// one byte gap, then start token and 512 byte datablock
+	SPI_transreceive(0xFF);
+	SPI_transreceive(startToken);
+	
+	for(uint16_t i = 0; i < 512; i++)
+	SPI_transreceive(_SDBuffer[i]);
+	
+	// dummy CRC
+	SPI_transreceive(0xFF);
+	SPI_transreceive(0xFF);
+	
+	// wait for data response token
+	attempts = 0;
+	while(++attempts != SD_MAX_READ_ATTEMPTS)
+	if( (read = SPI_transreceive(0xFF)) != 0xFF ) break;
+	
+	read &= 0x1F;
+	
+	if(read == SD_DATA_ACCEPTED && SDWaitReady() == SD_FAIL)
+	read = 0x00;
+	
+	return read;
+}
+
+
+/**
+*
+* @brief Write Single Block (CMD24)
+*
+* Write the 512 byte of _SDBuffer[] (sdcard.h) to a specific address. The function
+* returns after the SDcard has finished the programming of the block.
+*
+* @note same block addressing as SDReadBlock()
+*
+* @param addr address/sector of the datablock
+*
+* @param token data response: SD_DATA_ACCEPTED if the block was written
+*
+* @return R1 response message
+*
+*/
+uint8_t SDWriteBlock(uint32_t addr, uint8_t *token)
+{
+	uint8_t res;
+	
+	// empty data token
+	*token = 0xFF;
+	
+	// activate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_ENABLE;
+	SPI_transreceive(0xFF);
+	
+	// send Write Single Block Command (CMD24)
+	SDCommand(CMD24, addr, CMD24_CRC);
+	
+	// read response of format R1
+	res = SDReadR1();
+	
+	// command accepted?
+	if(res == SD_READY)
+	*token = SDWriteData(SD_START_TOKEN);
+	
+	// deactivate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_DISABLE;
+	SPI_transreceive(0xFF);
+	
+	return res;
+}
+
+
+/**
+*
+* @brief Start a Multiple Block Write (ACMD23, CMD25)
+*
+* The count of blocks is announced with ACMD23, so the SDcard can erase them
+* in advance. The blocks are sent with SDWriteMultiBlock() and the write is
+* finished with SDWriteMultiStop().
+*
+* @note The chip select is released between the blocks, other SPI devices (ethernet)
+* can be used during the write, but no other SDcard command.
+*
+* @param addr address/sector of the first datablock
+*
+* @param count count of blocks to write (pre-erase hint, 0: no pre-erase)
+*
+* @return R1 response message of CMD25
+*
+*/
+uint8_t SDWriteMultiStart(uint32_t addr, uint32_t count)
+{
+	uint8_t res;
+	
+	// pre-erase is only a hint, a rejected ACMD23 does not stop the write
+	if(count > 0 && SD_R1_NO_ERROR(SDSendApp()))
+	{
+		SPI_transreceive(0xFF);
+		CS_ENABLE;
+		SPI_transreceive(0xFF);
+		
+		// send Set Write Block Erase Count (ACMD23, 23 bit)
+		SDCommand(ACMD23, count & 0x007FFFFF, ACMD23_CRC);
+		SDReadR1();
+		
+		SPI_transreceive(0xFF);
+		CS_DISABLE;
+		SPI_transreceive(0xFF);
+	}
+	
+	// activate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_ENABLE;
+	SPI_transreceive(0xFF);
+	
+	// send Write Multiple Block Command (CMD25)
+	SDCommand(CMD25, addr, CMD25_CRC);
+	
+	// read response of format R1
+	res = SDReadR1();
+	
+	// deactivate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_DISABLE;
+	SPI_transreceive(0xFF);
+	
+	return res;
+}
+
+
+/**
+*
+* @brief Write the next block of a Multiple Block Write
+*
+* Write the 512 byte of _SDBuffer[] (sdcard.h) to the next address after
+* SDWriteMultiStart().
+*
+* @return data response: SD_DATA_ACCEPTED if the block was written
+*
+*/
+uint8_t SDWriteMultiBlock(void)
+{
+	uint8_t token;
+	
+	// activate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_ENABLE;
+	
+	token = SDWriteData(SD_MULTI_START_TOKEN);
+	
+	// deactivate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_DISABLE;
+	SPI_transreceive(0xFF);
+	
+	return token;
+}
+
+
+/**
+*
+* @brief Finish a Multiple Block Write
+*
+* Send the stop token and wait until the SDcard has programmed the last block.
+* Has to be called also after a rejected block.
+*
+* @return SD_SUCCESS: write finished | SD_FAIL: SDcard still busy
+*
+*/
+uint8_t SDWriteMultiStop(void)
+{
+	uint8_t res;
+	
+	// activate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_ENABLE;
+	SPI_transreceive(0xFF);
+	
+	// stop token, the busy signal starts one byte later
+	SPI_transreceive(SD_STOP_TRAN_TOKEN);
+	SPI_transreceive(0xFF);
+	
+	res = SDWaitReady();
+	
+	// deactivate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_DISABLE;
+	SPI_transreceive(0xFF);
+	
+	return res;
+}
+
+
+/**
+*
+* @brief Read Multiple Block (CMD18)
+*
+* Read consecutive datablocks with one command. Every block is stored at
+* _SDBuffer[] (sdcard.h) and handed to the callback, the read is finished with
+* STOP_TRANSMISSION (CMD12).
+*
+* @note The chip select stays active during the read, the callback must not use
+* other SPI devices.
+*
+* @param addr address/sector of the first datablock
+*
+* @param count count of blocks to read
+*
+* @param token token of the last read datablock (SD_START_TOKEN: no error)
+*
+* @param blockCallback called for every block with its index (0...count-1),
+* returns 0 to continue or 1 to stop the read
+*
+* @return R1 response message of CMD18
+*
+*/
+uint8_t SDReadBlocks(uint32_t addr, uint32_t count, uint8_t *token, uint8_t (*blockCallback)(uint32_t index))
+{
+	uint8_t res, read = 0xFF;
+	uint16_t attempts;
+	
+	// empty data token
+	*token = 0xFF;
+	
+	// activate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_ENABLE;
+	SPI_transreceive(0xFF);
+	
+	// send Read Multiple Block Command (CMD18)
+	SDCommand(CMD18, addr, CMD18_CRC);
+	
+	// read response of format R1
+	res = SDReadR1();
+	
+	if(res == SD_READY)
+	{
+		for(uint32_t n = 0; n < count; n++)
+		{
+			// wait for start token of the next block
+			attempts = 0;
+			while(++attempts != SD_MAX_READ_ATTEMPTS)
+			if( (read = SPI_transreceive(0xFF)) != 0xFF ) break;
+			
+			if(read != SD_START_TOKEN)
+			break;
+			
+			// read 512 byte datablock
+			for(uint16_t i = 0; i < 512; i++)
+			_SDBuffer[i] = SPI_transreceive(0xFF);
+			
+			// read CRC
+			SPI_transreceive(0xFF);
+			SPI_transreceive(0xFF);
+			
+			if(blockCallback(n))
+			break;
+		}
+		
+		// fill up token with SD response
+		*token = read;
+		
+		// stop the data stream, the byte after the command is a stuff byte
+		SDCommand(CMD12, CMD12_ARG, CMD12_CRC);
+		SPI_transreceive(0xFF);
+		SDReadR1();
+		SDWaitReady();
+	}
+	
+	// deactivate SDcard over chip select
+	SPI_transreceive(0xFF);
+	CS_DISABLE;
+	SPI_transreceive(0xFF);
+	
+	return res;
+}
+
+
 /**
 *
 * @brief Read Operation Conditions Register (OCR) CMD58
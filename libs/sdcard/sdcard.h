@@ -57,6 +57,16 @@ uint8_t SDSendOpCond(void);
 
 uint8_t SDReadBlock(uint32_t, uint8_t*);
 
+uint8_t SDReadBlocks(uint32_t, uint32_t, uint8_t*, uint8_t (*)(uint32_t));
+
+uint8_t SDWriteBlock(uint32_t, uint8_t*);
+
+uint8_t SDWriteMultiStart(uint32_t, uint32_t);
+
+uint8_t SDWriteMultiBlock(void);
+
+uint8_t SDWriteMultiStop(void);
+
 uint8_t SDGoIdleState(void);
 
 uint8_t SDInit(void);
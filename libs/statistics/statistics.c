@@ -0,0 +1,178 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file statistics.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Statistics library
+ *
+ * Running min, max, mean and variance of a sample stream with constant memory.
+ * The values are accumulated as shifted data (first value of the interval as offset),
+ * which is numerically equivalent to Welford's algorithm but needs only additions and
+ * one multiplication per sample. Divisions are done once per interval in Stat_Result().
+ *
+*/
+
+#include "statistics.h"
+
+
+/**
+*
+* @brief Start a new interval
+*
+* @param acc Pointer of the accumulator
+*
+* @return void
+*
+*/
+void Stat_Reset(StatAccumulator *acc)
+{
+	acc->count = 0;
+	acc->min = 0xFFFF;
+	acc->max = 0;
+	acc->shift = 0;
+	acc->sum = 0;
+	acc->sumSq = 0;
+	
+	return;
+}
+
+
+/**
+*
+* @brief Add a value to the statistics
+*
+* @param acc Pointer of the accumulator
+* @param value sample value
+*
+* @return void
+*
+*/
+void Stat_Add(StatAccumulator *acc, uint16_t value)
+{
+	if(acc->count == 0)
+	acc->shift = value;
+	
+	// saturate instead of overflow
+	if(acc->count == 0xFFFFFFFF)
+	return;
+	
+	acc->count++;
+	
+	if(value < acc->min) acc->min = value;
+	if(value > acc->max) acc->max = value;
+	
+	int32_t d = (int32_t)value - acc->shift;
+	
+	acc->sum += d;
+	acc->sumSq += (uint32_t)d * (uint32_t)d;	// |d| < 2^16 -> d^2 fits in 32 bit
+	
+	return;
+}
+
+
+/**
+*
+* @brief Integer square root
+*
+* @param x radicand
+*
+* @return floor(sqrt(x))
+*
+*/
+static uint16_t Stat_Sqrt(uint32_t x)
+{
+	uint32_t result = 0;
+	uint32_t bit = (uint32_t)1 << 30;
+	
+	while(bit > x)
+	bit >>= 2;
+	
+	while(bit != 0)
+	{
+		if(x >= result + bit)
+		{
+			x -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	
+	return (uint16_t)result;
+}
+
+
+/**
+*
+* @brief Calculate the statistics of the interval
+*
+* mean = shift + sum / n
+* variance = (sumSq - sum * mean_shifted) / (n - 1), with mean_shifted in 8 fractional bits
+*
+* @param acc Pointer of the accumulator
+* @param result Pointer for the result (all values 0 if the interval is empty)
+*
+* @return void
+*
+*/
+void Stat_Result(const StatAccumulator *acc, StatResult *result)
+{
+	result->count = acc->count;
+	
+	if(acc->count == 0)
+	{
+		result->min = 0;
+		result->max = 0;
+		result->mean = 0;
+		result->stddev = 0;
+		return;
+	}
+	
+	result->min = acc->min;
+	result->max = acc->max;
+	
+	// mean of the shifted values with 8 fractional bits
+	int64_t meanQ8 = (acc->sum * 256) / (int64_t)acc->count;
+	
+	result->mean = (uint16_t)(acc->shift + ((meanQ8 + 128) >> 8));
+	
+	if(acc->count < 2)
+	{
+		result->stddev = 0;
+		return;
+	}
+	
+	int64_t squares = (int64_t)acc->sumSq - ((acc->sum * meanQ8) >> 8);
+	
+	if(squares < 0)
+	squares = 0;
+	
+	result->stddev = Stat_Sqrt((uint32_t)(squares / (int64_t)(acc->count - 1)));
+	
+	return;
+}
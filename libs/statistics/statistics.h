@@ -0,0 +1,71 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file statistics.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+*
+* @brief Running statistics of one channel
+*
+* Sums of the shifted data (x - first value) keep the numbers small and the
+* variance numerically stable without a division per sample.
+*
+*/
+typedef struct _StatAccumulator{
+	uint32_t count;		/**< count of values						*/
+	uint16_t min;		/**< minimum value							*/
+	uint16_t max;		/**< maximum value							*/
+	uint16_t shift;		/**< first value of the interval			*/
+	int64_t sum;		/**< sum of (x - shift)						*/
+	uint64_t sumSq;		/**< sum of (x - shift)^2					*/
+}StatAccumulator;
+
+/**
+*
+* @brief Statistics of one interval
+*
+*/
+typedef struct _StatResult{
+	uint32_t count;		/**< count of values		*/
+	uint16_t min;		/**< minimum value			*/
+	uint16_t max;		/**< maximum value			*/
+	uint16_t mean;		/**< mean value (rounded)	*/
+	uint16_t stddev;	/**< standard deviation		*/
+}StatResult;
+
+void Stat_Reset(StatAccumulator *acc);
+
+void Stat_Add(StatAccumulator *acc, uint16_t value);
+
+void Stat_Result(const StatAccumulator *acc, StatResult *result);
+
+#endif /* STATISTICS_H_ */
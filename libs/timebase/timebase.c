@@ -0,0 +1,242 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file timebase.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Monotonic timebase
+ *
+ * Timer1 runs in normal mode with prescaler /8 (one tick = 8 / F_CPU, 0.43us at 18.432MHz)
+ * and is extended by the overflow interrupt. The clock continues while the main loop
+ * is blocked, only the overflow interrupt must not be held off longer than one
+ * Timer1 period (65536 ticks, 28ms).
+ *
+ * The compare units of Timer1 stay free for other users (ADC trigger on compare match B).
+ *
+ * Microseconds and milliseconds are accumulated per overflow with the remainder
+ * of the division, so no 64 bit arithmetic is needed and the clock does not drift.
+ *
+*/
+
+#include "timebase.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#define TIMEBASE_US_DEN			(F_CPU / 1000UL)		/**< microsecond remainder unit: 1 / (F_CPU / 1000) us	*/
+
+static volatile uint16_t overflows = 0;		/**< Timer1 overflows (high word of the tick counter)	*/
+static volatile uint32_t ovfMicros = 0;		/**< microseconds at the last overflow					*/
+static volatile uint16_t ovfMicrosRem = 0;	/**< remainder of ovfMicros in 1/TIMEBASE_US_DEN us		*/
+static volatile uint32_t ovfMillis = 0;		/**< milliseconds at the last overflow					*/
+static volatile uint16_t ovfMillisRem = 0;	/**< remainder of ovfMillis in ticks					*/
+
+
+/**
+ *
+ * @brief Start the timebase
+ *
+ * Timer1 is started in normal mode with prescaler /8. If Timer1 already runs, only
+ * the overflow interrupt is enabled.
+ *
+ * @return void
+ *
+*/
+void Timebase_Init(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	
+	if((TCCR1B & ((1 << CS12) | (1 << CS11) | (1 << CS10))) == 0)
+	{
+		TCCR1A = 0;
+		TCNT1 = 0;
+		TCCR1B = (1 << CS11);
+		TIFR1 = (1 << TOV1);
+	}
+	
+	TIMSK1 |= (1 << TOIE1);
+	
+	SREG = sreg;
+	
+	return;
+}
+
+
+/**
+ *
+ * @brief Read Timer1 and a pending overflow atomically
+ *
+ * An overflow that occurred after interrupts were disabled has not been counted yet.
+ * It is only taken into account if the counter value was read after the overflow.
+ *
+ * @param pending set to true if an overflow is pending
+ *
+ * @return Timer1 counter value
+ *
+ * @note call with disabled interrupts
+ *
+*/
+static inline uint16_t Timebase_ReadCounter(bool *pending)
+{
+	uint16_t counter = TCNT1;
+	
+	*pending = (TIFR1 & (1 << TOV1)) && counter < 0x8000;
+	
+	return counter;
+}
+
+
+/**
+ *
+ * @brief Read the tick counter
+ *
+ * 32 bit tick counter with TIMEBASE_TICKS_PER_MS ticks per millisecond.
+ * It wraps after 31 minutes, differences of two values are valid below that time.
+ *
+ * @return Timer1 ticks since the start of the timebase
+ *
+*/
+uint32_t Timebase_Ticks(void)
+{
+	bool pending;
+	uint16_t high;
+	uint16_t counter;
+	
+	uint8_t sreg = SREG;
+	cli();
+	counter = Timebase_ReadCounter(&pending);
+	high = overflows;
+	SREG = sreg;
+	
+	if(pending)
+	high++;
+	
+	return ((uint32_t)high << 16) | counter;
+}
+
+
+/**
+ *
+ * @brief Extend a 16 bit Timer1 value to the 32 bit tick counter
+ *
+ * Used for values captured in hardware (e.g. compare registers).
+ * The stamp must be less than one Timer1 period older than now.
+ *
+ * @param now current tick counter (Timebase_Ticks)
+ * @param stamp Timer1 value
+ *
+ * @return tick counter at the time of the stamp
+ *
+*/
+uint32_t Timebase_Extend(uint32_t now, uint16_t stamp)
+{
+	return now - (uint16_t)((uint16_t)now - stamp);
+}
+
+
+/**
+ *
+ * @brief Read the microsecond clock
+ *
+ * Wraps after 71 minutes.
+ *
+ * @return microseconds since the start of the timebase
+ *
+*/
+uint32_t Timebase_Micros(void)
+{
+	bool pending;
+	uint16_t counter;
+	uint32_t micros;
+	uint32_t rem;
+	
+	uint8_t sreg = SREG;
+	cli();
+	counter = Timebase_ReadCounter(&pending);
+	micros = ovfMicros;
+	rem = ovfMicrosRem;
+	SREG = sreg;
+	
+	// one tick = 8000 / (F_CPU / 1000) us
+	rem += (uint32_t)counter * 8000;
+	
+	if(pending)
+	rem += 65536UL * 8000;
+	
+	return micros + rem / TIMEBASE_US_DEN;
+}
+
+
+/**
+ *
+ * @brief Read the millisecond clock
+ *
+ * Wraps after 49 days.
+ *
+ * @return milliseconds since the start of the timebase
+ *
+*/
+uint32_t Timebase_Millis(void)
+{
+	bool pending;
+	uint16_t counter;
+	uint32_t millis;
+	uint32_t rem;
+	
+	uint8_t sreg = SREG;
+	cli();
+	counter = Timebase_ReadCounter(&pending);
+	millis = ovfMillis;
+	rem = ovfMillisRem;
+	SREG = sreg;
+	
+	rem += counter;
+	
+	if(pending)
+	rem += 65536UL;
+	
+	return millis + rem / TIMEBASE_TICKS_PER_MS;
+}
+
+
+/**
+ *
+ * @brief Interrupt function for Timer1 overflow
+ *
+ * Extend the tick counter and accumulate one Timer1 period (65536 ticks) in
+ * microseconds and milliseconds.
+ *
+*/
+ISR(TIMER1_OVF_vect)
+{
+	overflows++;
+	
+	uint32_t rem = ovfMicrosRem + 65536UL * 8000;
+	ovfMicros += rem / TIMEBASE_US_DEN;
+	ovfMicrosRem = rem % TIMEBASE_US_DEN;
+	
+	rem = ovfMillisRem + 65536UL;
+	ovfMillis += rem / TIMEBASE_TICKS_PER_MS;
+	ovfMillisRem = rem % TIMEBASE_TICKS_PER_MS;
+}
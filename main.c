@@ -85,7 +85,6 @@
  *
  * @brief Entry point and state machine implementation.
  *
- * @todo write measurement values to sdcard, if target server is unavailable.
  * @todo edit tuxgraphics ethernet library to set user defined target URLs.
  * @todo update tuxgraphics ethernet library to prevent warning during compiling process.
  * @todo implement more http request types like PUT and POST.
@@ -93,6 +92,7 @@
 */
 
 #include <avr/io.h>
+#include <string.h>
 
 #include "ioconfig.h"
 
@@ -101,6 +101,8 @@
 #include "libs/sdcard/sdcard.h"
 #include "libs/uart/uart.h"
 #include "libs/adc/adc.h"
+#include "libs/timebase/timebase.h"
+#include "libs/scheduler/scheduler.h"
 #include "libs/ethernet/ethernet.h"
 #include "libs/lcd/lcd_lib.h"
 
@@ -119,7 +121,14 @@
 
 #include "routines/autoconfigRoutine.h"
 #include "routines/measureRoutine.h"
+#include "routines/reportRoutine.h"
+#include "routines/captureRoutine.h"
+#include "routines/batchRoutine.h"
+#include "routines/telemetryRoutine.h"
+#include "routines/mqttRoutine.h"
 #include "routines/runRoutine.h"
+#include "routines/spoolRoutine.h"
+#include "routines/logRoutine.h"
 
 //
 // pulse variables (pulse generated by hardware timer)
@@ -134,12 +143,17 @@ uint8_t ip[] = {0,0,0,0};	/**< target server IPv4 Adresse	*/
 uint32_t port = 0;			/**< target port				*/
 uint32_t interval = 0;		/**< sending interval			*/
 char hostname[25];			/**< hostname of target server	*/
+uint8_t outputMode = OUTPUT_DEFAULT;	/**< CONFIG_OUTPUT_HTTP | CONFIG_OUTPUT_UDP | CONFIG_OUTPUT_MQTT	*/
 
 //
 // sensor specific variables
 //
-uint16_t sensorValue = 0;
-uint32_t sec_until_send = 0;
+uint16_t sensorValues[ADC_SCAN_COUNT];			/**< last values of the scan list	*/
+uint32_t sensorTimestamp = 0;					/**< Timebase ticks of sensorValues	*/
+StatResult sensorStats[ADC_SCAN_COUNT];			/**< statistics of the last interval	*/
+uint16_t reportValues[ADC_SCAN_MAX_CHANNELS];	/**< values of the reported interval		*/
+uint32_t reportSeconds = 0;						/**< time of reportValues in seconds		*/
+uint32_t sendSlots = 1;							/**< intervals covered by the current send slot	*/
 
 //
 // network parameter source
@@ -166,6 +180,9 @@ uint8_t selectedSource = 0;		/**< target ip or hostname 1: ip | 2: hostname */
 #define STATE_CHOOSESOURCE	11	/**< choose target address (ip or hostname)			*/
 #define STATE_MANUALIP		12	/**< manual network configuration					*/
 #define STATE_SHOWNETWORK	13	/**< display network configuration					*/
+#define STATE_CAPTURE		14	/**< upload a triggered capture						*/
+#define STATE_PING			15	/**< keep the MQTT session alive					*/
+#define STATE_DRAIN			16	/**< send samples of the SDcard spool				*/
 
 uint8_t state = STATE_INIT;	/**< current datalogger state */
 
@@ -179,14 +196,37 @@ uint8_t state = STATE_INIT;	/**< current datalogger state */
 * @brief Hardware port initialization
 *
 * initialization of SPI hardware, Timer with overflow interrupt and ADC
+* Timer1 is the monotonic timebase, the ADC scans are started in hardware by
+* its compare unit B with ADC_SAMPLE_RATE.
 *
 * @return void
 */
 void init_Ports(void)
 {
 	SPI_init();
+	
+	Timebase_Init();
 
 	ADC_Init();
+	
+	measureInit();
+	reportInit();
+	#if defined(HTTP_BATCH) || defined(SD_SPOOL)
+	batchInit();
+	#endif
+	
+	// background tasks
+	Scheduler_AddTask(&measureTask, MEASURE_POLL_PERIOD);
+	Scheduler_AddTask(&Ethernet_PollTask, ETHERNET_POLL_PERIOD);
+	logInit();	// started with the datalogger
+	
+	#ifdef HTTP_KEEPALIVE
+	Ethernet_SetKeepAlive(true);
+	#endif
+	
+	#ifdef MEASURE_CAPTURE
+	captureInit();
+	#endif
 
 	initDisplay();
 
@@ -203,6 +243,7 @@ void init_Ports(void)
 
 	#ifdef DEBUG_MODE
 	UART_init(BAUDRATE, F_CPU);
+	ADC_EnableJitterMeasurement(true);
 	#endif
 	
 	sei(); // activate interrupt
@@ -211,6 +252,61 @@ void init_Ports(void)
 }
 
 
+#ifdef SD_SPOOL
+/**
+*
+* @brief Send spooled values
+*
+* The values are sent with the UDP or MQTT output, without statistics and with
+* their age (min. 1 s, 0 would mark current values).
+*
+* @param values measurement values (one per channel of the scan list)
+* @param seconds time of the values in seconds
+*
+* @return true: values sent | false: transmission failed
+*/
+static bool sendSpooled(uint16_t *values, uint32_t seconds)
+{
+	uint8_t *target = (selectedSource == SOURCE_STATICIP) ? ip : NULL;
+	uint32_t now = Timebase_Millis() / 1000;
+	uint32_t age = (now > seconds) ? now - seconds : 1;
+	
+	if(outputMode == CONFIG_OUTPUT_UDP)
+	{
+		telemetrySet(values, NULL, age);
+		return Ethernet_SendUDP(target, port, &telemetryFormat);
+	}
+	
+	mqttSet(values, NULL, age);
+	return Ethernet_SendTCP(target, port, &mqttFormat, &mqttAnswer);
+}
+#endif
+
+/**
+*
+* @brief Query generator of the GET request
+*
+* Format the measurement values (or their statistics) directly into the packet buffer.
+*
+* @param query output for the urlencoded query
+* @param size free space in the packet
+*
+* @return length of the query (0: no space)
+*/
+static uint16_t sendQueryFormat(char *query, uint16_t size)
+{
+	if(size < MEASURE_STRING_SIZE)
+	return 0;
+	
+	#ifdef MEASURE_STATISTICS
+	measureFormatStatistics(sensorStats, query);
+	#else
+	measureFormatValues(sensorValues, query);
+	#endif
+	
+	return strlen(query);
+}
+
 
 
 
@@ -234,6 +330,8 @@ int main(void)
 	
 	while(1)
 	{
+		Scheduler_Yield();	// background tasks
+		
 		if(state == STATE_INIT)
 		{
 			startupView();
@@ -282,7 +380,7 @@ int main(void)
 		
 		else if(state == STATE_AUTOCONFIG)
 		{
-			if(autoconfig_routine((char*)hostname, (uint8_t*)ip, &port, &interval) == 1)
+			if(autoconfig_routine((char*)hostname, (uint8_t*)ip, &port, &interval, &outputMode) == 1)
 			{
 				messageView("Konfig. Fehler", &pulse10ms);
 				state = STATE_SETUP;
@@ -314,7 +412,24 @@ int main(void)
 			
 			if(idleResponse == true)
 			{
-				sec_until_send = interval;
+				runStart(interval);
+				
+				// a new run starts with a transmission and new statistics
+				reportInit();
+				measureStatisticsReset();
+				
+				// samples of a failed upload are stored on the SDcard (if available)
+				#ifdef HTTP_BATCH
+				spoolInit(outputMode != CONFIG_OUTPUT_HTTP);
+				#else
+				spoolInit(true);
+				#endif
+				
+				logStart();
+				
+				// the MQTT session stays open between the publishes
+				if(outputMode == CONFIG_OUTPUT_MQTT)
+				Ethernet_SetKeepAlive(true);
 				
 				if(selectedSource == SOURCE_STATICIP)
 				state = STATE_RUN;
@@ -338,36 +453,273 @@ int main(void)
 		else if(state == STATE_RUN)
 		{
 			// stop datalogger until click on EXIT
-			if(runView(&pulse10ms, &pulse500ms, &sec_until_send)){state = STATE_IDLE; continue;}
+			uint8_t runResponse = runView(&pulse10ms, &pulse500ms);
+			if(runResponse == 1)
+			{
+				// a failed log (card removed or full) is shown at the end of the run
+				if(!logStop())
+				messageView("> Log Fehler", &pulse10ms);
+				
+				state = STATE_IDLE;
+				continue;
+			}
+			if(runResponse == 2){state = STATE_CAPTURE; continue;}
+			if(runResponse == 3){state = STATE_DRAIN; continue;}
 			
-			if(sec_until_send == 0){state = STATE_MEASURE;}
+			// send slot reached: the next deadline is independent of the upload time
+			sendSlots = runAdvance();
+			state = STATE_MEASURE;
 		}
 		/*end of STATE_RUN*/
 
 		else if(state == STATE_SEND)
 		{
+			if(outputMode == CONFIG_OUTPUT_UDP)
+			{
+				// one datagram per send slot, no connection and no message on the display
+				#ifdef MEASURE_STATISTICS
+				telemetrySet(reportValues, sensorStats, 0);
+				#else
+				telemetrySet(reportValues, NULL, 0);
+				#endif
+				
+				bool sent;
+				if(selectedSource == SOURCE_STATICIP)
+				sent = Ethernet_SendUDP(ip, port, &telemetryFormat);
+				else
+				sent = Ethernet_SendUDP(NULL, port, &telemetryFormat);
+				
+				// not sent: the sample is spooled, without spool the report stays pending
+				spoolOnline(sent);
+				if(sent || spoolPush(reportValues, reportSeconds))
+				reportSent(sensorValues, ADC_GetScanChannelCount());
+				
+				state = STATE_RUN;
+				continue;
+			}
+			
+			if(outputMode == CONFIG_OUTPUT_MQTT)
+			{
+				// publish on the open session, no message on the display
+				#ifdef MEASURE_STATISTICS
+				mqttSet(reportValues, sensorStats, 0);
+				#else
+				mqttSet(reportValues, NULL, 0);
+				#endif
+				
+				bool sent;
+				if(selectedSource == SOURCE_STATICIP)
+				sent = Ethernet_SendTCP(ip, port, &mqttFormat, &mqttAnswer);
+				else
+				sent = Ethernet_SendTCP(NULL, port, &mqttFormat, &mqttAnswer);
+				
+				spoolOnline(sent);
+				if(sent || spoolPush(reportValues, reportSeconds))
+				reportSent(sensorValues, ADC_GetScanChannelCount());
+				
+				state = STATE_RUN;
+				continue;
+			}
+			
 			messageView("> senden...", &pulse10ms);
 			
-			// convert measure value to string for GET request
-			char sensorValueString[4];
-			itoa(sensorValue, sensorValueString, 10);
+			#ifdef DEBUG_MODE
+			// trigger-to-read latency of the ADC in Timer1 ticks
+			ADC_JitterStat jitterStat;
+			ADC_GetJitter(&jitterStat);
+			UART_puts("ADC latency min/max: ");
+			UART_putU16(jitterStat.min);
+			UART_putc('/');
+			UART_putU16(jitterStat.max);
+			UART_puts("\r\n");
+			
+			// CPU cycles of the filter chains per sample
+			uint16_t filterMin, filterMax;
+			measureFilterTicks(&filterMin, &filterMax);
+			UART_puts("filter cycles/sample min/max: ");
+			UART_putU16((uint32_t)filterMin * 8 / ADC_GetScanChannelCount());
+			UART_putc('/');
+			UART_putU16((uint32_t)filterMax * 8 / ADC_GetScanChannelCount());
+			UART_puts("\r\n");
+			#endif
 			
+			#ifdef HTTP_BATCH
+			// all samples of the batch in one POST, the body is formatted directly into the packet buffer
+			// failed: the samples are kept and sent again with the next slot
+			if(Ethernet_SendPOST_p(selectedSource == SOURCE_STATICIP, PSTR(BATCH_URL), ip, hostname, &batchFormatBody))
+			{
+				batchClear();
+				
+				// spooled samples are older than the next live sample: they fill the new batch first
+				uint16_t spoolValues[ADC_SCAN_MAX_CHANNELS];
+				uint32_t spoolSeconds;
+				while(spoolPeek(0, spoolValues, &spoolSeconds))
+				{
+					spoolPop();
+					if(batchAdd(spoolValues, spoolSeconds))
+					break;
+				}
+				spoolCommit();
+			}
+			else
+			messageView("> Fehler", &pulse10ms);
+			#else
+			// the measure values are formatted directly into the GET request
+			bool sent;
 			if(selectedSource == SOURCE_STATICIP)
-			Ethernet_SendGET_p(true, sensorValueString, PSTR(WEBSERVER_URL), ip, hostname);
+			sent = Ethernet_SendGET_p(true, PSTR(WEBSERVER_URL), ip, hostname, &sendQueryFormat);
 			else
-			Ethernet_SendGET_p(false, sensorValueString, PSTR(WEBSERVER_URL), NULL, hostname);
+			sent = Ethernet_SendGET_p(false, PSTR(WEBSERVER_URL), NULL, hostname, &sendQueryFormat);
+			
+			spoolOnline(sent);
+			if(sent || spoolPush(reportValues, reportSeconds))
+			reportSent(sensorValues, ADC_GetScanChannelCount());
 			
-			sec_until_send = interval;
+			if(!sent)
+			messageView("> Fehler", &pulse10ms);
+			#endif
 			
 			state = STATE_RUN;
 		}
 		/*end of STATE_SEND*/
 		
+		#ifdef MEASURE_CAPTURE
+		else if(state == STATE_CAPTURE)
+		{
+			// the burst is an HTTP POST: with UDP/MQTT output there is no target for it
+			if(outputMode == CONFIG_OUTPUT_HTTP)
+			{
+				messageView("> capture...", &pulse10ms);
+				
+				// the burst is formatted directly into the packet buffer
+				if(!Ethernet_SendPOST_p(selectedSource == SOURCE_STATICIP, PSTR(CAPTURE_URL), ip, hostname, &captureFormatBody))
+				messageView("> Fehler", &pulse10ms);
+			}
+			
+			// the burst is released also on failure, the capture buffer is needed for the next trigger
+			captureRelease();
+			
+			state = STATE_RUN;
+		}
+		/*end of STATE_CAPTURE*/
+		#endif
+		
+		else if(state == STATE_PING)
+		{
+			mqttSet(NULL, NULL, 0);
+			
+			if(selectedSource == SOURCE_STATICIP)
+			Ethernet_SendTCP(ip, port, &mqttFormat, &mqttAnswer);
+			else
+			Ethernet_SendTCP(NULL, port, &mqttFormat, &mqttAnswer);
+			
+			state = STATE_RUN;
+		}
+		/*end of STATE_PING*/
+		
+		#ifdef SD_SPOOL
+		else if(state == STATE_DRAIN)
+		{
+			// oldest samples first, a failure stops the drain until the next successful send
+			uint16_t spoolValues[ADC_SCAN_MAX_CHANNELS];
+			uint32_t spoolSeconds;
+			
+			if(outputMode == CONFIG_OUTPUT_HTTP)
+			{
+				// one bulk-update POST with the time of every sample (with HTTP_BATCH
+				// the batch itself takes the spooled samples, there is no drain)
+				uint32_t count = 0;
+				
+				batchClear();
+				while(spoolPeek(count, spoolValues, &spoolSeconds))
+				{
+					count++;
+					if(batchAdd(spoolValues, spoolSeconds))
+					break;
+				}
+				
+				// the samples are removed only after the upload
+				bool sent = Ethernet_SendPOST_p(selectedSource == SOURCE_STATICIP, PSTR(BATCH_URL), ip, hostname, &batchFormatBody);
+				spoolOnline(sent);
+				if(sent)
+				{
+					while(count--)
+					spoolPop();
+				}
+				
+				batchClear();
+			}
+			else
+			{
+				for(uint8_t n = 0; n < SPOOL_DRAIN_COUNT && spoolPeek(0, spoolValues, &spoolSeconds); n++)
+				{
+					if(!sendSpooled(spoolValues, spoolSeconds))
+					{
+						spoolOnline(false);
+						break;
+					}
+					
+					spoolPop();
+				}
+			}
+			
+			spoolCommit();
+			
+			state = STATE_RUN;
+		}
+		/*end of STATE_DRAIN*/
+		#endif
+		
 		else if(state == STATE_MEASURE)
 		{
-			measureRoutine(&sensorValue);
+			measureRoutine(sensorValues, &sensorTimestamp);
+			
+			#ifdef MEASURE_STATISTICS
+			measureStatistics(sensorStats);
+			
+			for(uint8_t i = 0; i < ADC_SCAN_COUNT; i++)
+			reportValues[i] = sensorStats[i].mean;
+			#else
+			for(uint8_t i = 0; i < ADC_SCAN_COUNT; i++)
+			reportValues[i] = sensorValues[i];
+			#endif
+			
+			// time of the values on the millisecond clock
+			reportSeconds = (Timebase_Millis() - (Timebase_Ticks() - sensorTimestamp) / TIMEBASE_TICKS_PER_MS) / 1000;
 			
-			state = STATE_SEND;
+			// send only if a current value left the deadband or the heartbeat is due
+			// (the mean of suppressed intervals would smear a step over the whole silence)
+			if(reportRoutine(sensorValues, ADC_GetScanChannelCount(), sendSlots * interval))
+			{
+				state = STATE_SEND;
+				
+				// the statistics are reported, a suppressed interval is part of the next one
+				#ifdef MEASURE_STATISTICS
+				measureStatisticsReset();
+				#endif
+				
+				#ifdef HTTP_BATCH
+				if(outputMode == CONFIG_OUTPUT_HTTP)
+				{
+					// the values are reported as soon as they are part of the batch
+					// (full batch after a failed upload: the values wait in the spool)
+					bool stored = true;
+					
+					if(batchFull())
+					stored = spoolPush(reportValues, reportSeconds);
+					else if(!batchAdd(reportValues, reportSeconds))
+					state = STATE_RUN;
+					
+					// not stored (no spool): the report stays pending
+					if(stored)
+					reportSent(sensorValues, ADC_GetScanChannelCount());
+				}
+				#endif
+			}
+			else if(outputMode == CONFIG_OUTPUT_MQTT && mqttPingDue())
+			state = STATE_PING;
+			else
+			state = STATE_RUN;
 		}
 		/*end of STATE_MEASURE*/
 		
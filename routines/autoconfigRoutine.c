@@ -30,6 +30,8 @@
  * This configuration routine establish connection to SDcard and read the configuration
  * parameters for the datalogger at file 'config.txt'.
  * Parameters have to be in follow format: IP;Port;Interval;Hostname;
+ * An optional fifth parameter selects the output: IP;Port;Interval;Hostname;udp;
+ * (udp: UDP datagrams to IP:Port | mqtt: MQTT broker at IP:Port | http: HTTP requests to the hostname)
  *
  * @note for this file, the SD library is required. Please include sdcard.h
  *
@@ -50,6 +52,7 @@ struct Config_Structure{
 	uint32_t port;
 	uint32_t interval;
 	char host[25];
+	uint8_t output;
 };
 
 /**
@@ -217,6 +220,35 @@ void extractHostname(uint8_t *posIndex, struct Config_Structure *config, char* d
 }
 
 
+/**
+*
+* @brief Extract output mode from input string
+*
+* @param posIndex position index in textfile (at the ';' after the hostname)
+* @param config configuration structure
+* @param data string out of textfile
+* @return 1: parameter not available | 0: OK
+*
+*/
+uint8_t extractOutput(uint8_t *posIndex, struct Config_Structure *config, char* data)
+{
+	if(data[*posIndex] != ';')
+	return 1;
+	
+	*posIndex += 1; // ';' overjump character
+	
+	if(strncasecmp(&data[*posIndex], "udp", 3) == 0)
+	config->output = CONFIG_OUTPUT_UDP;
+	else if(strncasecmp(&data[*posIndex], "mqtt", 4) == 0)
+	config->output = CONFIG_OUTPUT_MQTT;
+	else if(strncasecmp(&data[*posIndex], "http", 4) == 0)
+	config->output = CONFIG_OUTPUT_HTTP;
+	else
+	return 1;
+	
+	return 0;
+}
+
 /**
 *
 * @brief Automatic configuration routine
@@ -227,11 +259,12 @@ void extractHostname(uint8_t *posIndex, struct Config_Structure *config, char* d
 * @param ip_address ip address pointer
 * @param port port Pointer
 * @param interval interval Pointer
+* @param output output mode Pointer (unchanged, if not in the file)
 *
 * @return 1: file empty or not found | 0: routine sucessfull
 *
 */
-uint8_t autoconfig_routine(char* host, uint8_t *ip_address, uint32_t *port, uint32_t *interval)
+uint8_t autoconfig_routine(char* host, uint8_t *ip_address, uint32_t *port, uint32_t *interval, uint8_t *output)
 {
 	
 	// initialize SDcard
@@ -265,6 +298,9 @@ uint8_t autoconfig_routine(char* host, uint8_t *ip_address, uint32_t *port, uint
 	
 	extractHostname(&posIndex, &config, data);
 	
+	if(extractOutput(&posIndex, &config, data) == 0)
+	*output = config.output;
+	
 	
 	memcpy(host, config.host, 25);
 	ip_address[0] = config.ip_address[0];
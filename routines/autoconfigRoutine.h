@@ -31,6 +31,10 @@
 
 #include <stdint.h>
 
-uint8_t autoconfig_routine(char* host, uint8_t *ip_address, uint32_t *port, uint32_t *interval);
+#define CONFIG_OUTPUT_HTTP	0	/**< values are sent with HTTP requests	*/
+#define CONFIG_OUTPUT_UDP	1	/**< values are sent as UDP datagrams	*/
+#define CONFIG_OUTPUT_MQTT	2	/**< values are published to a broker	*/
+
+uint8_t autoconfig_routine(char* host, uint8_t *ip_address, uint32_t *port, uint32_t *interval, uint8_t *output);
 
 #endif /* AUTOCONFIG_ROUTINE_H_ */
\ No newline at end of file
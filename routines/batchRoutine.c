@@ -0,0 +1,224 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file batchRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Batched upload routine
+ *
+ * Samples are collected with their time in a compact delta encoding (one block per
+ * channel) and uploaded with one POST request in the bulk-update CSV format of thingspeak:
+ *
+ * write_api_key=KEY&time_format=relative&updates=30,512.250|15,513.000|...
+ *
+ * The first column is the time in seconds relative to the previous entry (first entry:
+ * seconds before the upload), followed by field1...fieldN. So samples from the spool
+ * keep their time, although there is no wall clock. The body is written directly into the packet buffer, so the
+ * batch is limited to one TCP packet. The batch is ready for upload at BATCH_SIZE samples
+ * or if the next sample may not fit into the body anymore (with more than one channel
+ * before BATCH_SIZE, see batchRoutine.h).
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "batchRoutine.h"
+#include "measureRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include "../libs/encoding/encoding.h"
+#include "../libs/timebase/timebase.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_CHANNELS		ADC_SCAN_COUNT	/**< count of channels in the scan list */
+
+#define BATCH_ENTRY_MAX		(11 + BATCH_CHANNELS * (MEASURE_VALUE_SIZE + 1))	/**< max. size of one entry "|time,value,..." */
+
+static uint8_t store[BATCH_CHANNELS][BATCH_BLOCK_SIZE];	/**< encoded samples of every channel			*/
+static EncodeBlock blocks[BATCH_CHANNELS];				/**< encoder state of every channel				*/
+static uint16_t bodyLength = 0;							/**< size of the formatted sample list			*/
+static uint32_t lastSeconds = 0;						/**< time of the newest sample					*/
+
+/**
+*
+* @brief Start an empty batch
+*
+* @return void
+*/
+void batchInit(void)
+{
+	batchClear();
+}
+
+/**
+*
+* @brief Remove all samples of the batch (after the upload)
+*
+* @return void
+*/
+void batchClear(void)
+{
+	for(uint8_t i = 0; i < BATCH_CHANNELS; i++)
+	Encode_Begin(&blocks[i], store[i], BATCH_BLOCK_SIZE);
+	
+	bodyLength = 0;
+}
+
+/**
+*
+* @brief Count of samples in the batch
+*
+* @return count of samples
+*/
+uint8_t batchCount(void)
+{
+	return (uint8_t)blocks[0].count;
+}
+
+/**
+*
+* @brief Check if the batch is full
+*
+* @return true: no space for another sample | false: batch can take more samples
+*/
+bool batchFull(void)
+{
+	if(blocks[0].count >= BATCH_SIZE || bodyLength + BATCH_ENTRY_MAX > BATCH_BODY_MAX)
+	return true;
+	
+	for(uint8_t i = 0; i < BATCH_CHANNELS; i++)
+	{
+		if(blocks[i].length + ENCODE_MAX_SAMPLE_SIZE > blocks[i].size)
+		return true;
+	}
+	
+	return false;
+}
+
+/**
+*
+* @brief Add a sample to the batch
+*
+* The space is checked after every sample, so the following sample always fits.
+* If the batch is still full (failed upload), the sample is dropped and the
+* collected samples are kept for the next attempt.
+*
+* @param values measurement values (one per channel of the scan list)
+* @param seconds time of the sample in seconds
+*
+* @return true: batch ready for upload | false: batch can take more samples
+*/
+bool batchAdd(uint16_t *values, uint32_t seconds)
+{
+	char number[11];
+	
+	if(batchFull())
+	return true;
+	
+	// time relative to the previous entry, the age of the first entry is only known at the upload
+	if(blocks[0].count == 0)
+	{
+		bodyLength += 10;
+	}
+	else
+	{
+		ultoa(seconds - lastSeconds, number, 10);
+		bodyLength += strlen(number) + 1;
+	}
+	
+	for(uint8_t i = 0; i < BATCH_CHANNELS; i++)
+	{
+		Encode_Add(&blocks[i], seconds, values[i]);
+		bodyLength += 1 + (measureFormatValue(i, values[i], number) - number);
+	}
+	
+	lastSeconds = seconds;
+	
+	return batchFull();
+}
+
+/**
+*
+* @brief Format the batch as POST body
+*
+* Entries which do not fit into the body are left out.
+*
+* @param body output buffer
+* @param size size of the output buffer
+*
+* @return length of the body
+*/
+uint16_t batchFormatBody(char *body, uint16_t size)
+{
+	DecodeBlock decoder[BATCH_CHANNELS];
+	char entry[BATCH_ENTRY_MAX + 1];
+	uint32_t seconds, previous = 0;
+	uint32_t now = Timebase_Millis() / 1000;
+	uint16_t value;
+	uint16_t len;
+	
+	static const char prefix[] PROGMEM = "write_api_key=" BATCH_API_KEY "&time_format=relative&updates=";
+	
+	if(size < sizeof(prefix))
+	return 0;
+	
+	strcpy_P(body, prefix);
+	len = sizeof(prefix) - 1;
+	
+	for(uint8_t i = 0; i < BATCH_CHANNELS; i++)
+	Decode_Begin(&decoder[i], store[i], blocks[i].length);
+	
+	for(uint8_t n = 0; n < blocks[0].count; n++)
+	{
+		char *pos = entry;
+		
+		if(n > 0)
+		*pos++ = '|';
+		
+		for(uint8_t i = 0; i < BATCH_CHANNELS; i++)
+		{
+			if(!Decode_Next(&decoder[i], &seconds, &value))
+			return len;
+			
+			if(i == 0)
+			{
+				ultoa((n == 0) ? ((now > seconds) ? now - seconds : 0) : seconds - previous, pos, 10);
+				pos += strlen(pos);
+				previous = seconds;
+			}
+			
+			*pos++ = ',';
+			pos = measureFormatValue(i, value, pos);
+		}
+		
+		uint8_t entryLen = pos - entry;
+		if(len + entryLen > size)
+		break;
+		
+		memcpy(&body[len], entry, entryLen);
+		len += entryLen;
+	}
+	
+	return len;
+}
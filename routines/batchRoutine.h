@@ -0,0 +1,57 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file batchRoutine.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef BATCH_ROUTINE_H_
+#define BATCH_ROUTINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The POST body is the limit of a batch: the sample list has to fit into one packet
+// (650 byte buffer minus headers and prefix). A sample with one channel and 3 decimal
+// places takes up to 11 characters ("|15,512.250"), so about 25 samples fit; every further
+// channel takes 8 characters more per sample. BATCH_SIZE is set to this limit and the
+// encoded storage holds BATCH_SIZE samples with 4 byte deltas (time < 4.5 h, value +-8191)
+// plus the base sample and the headroom checked by batchFull().
+#define BATCH_SIZE			24		/**< max. count of samples per upload							*/
+#define BATCH_BLOCK_SIZE	104		/**< encoded storage per channel in bytes (8 + 22 * 4 + 8)		*/
+#define BATCH_BODY_MAX		300		/**< max. size of the sample list in the POST body (one packet)	*/
+
+void batchInit(void);
+
+bool batchAdd(uint16_t *values, uint32_t seconds);
+
+uint8_t batchCount(void);
+
+bool batchFull(void);
+
+uint16_t batchFormatBody(char *body, uint16_t size);
+
+void batchClear(void);
+
+#endif /* BATCH_ROUTINE_H_ */
@@ -0,0 +1,122 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file captureRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Triggered capture routine
+ *
+ * Connect the triggered capture to the sample stream of the ADC and format the
+ * frozen burst for the upload.
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "captureRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include "../libs/capture/capture.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*
+* @brief Start the triggered capture
+*
+* The capture gets every sample of CAPTURE_CHANNEL directly from the ADC interrupt.
+*
+* @return void
+*/
+void captureInit(void)
+{
+	Capture_Init(CAPTURE_THRESHOLD, CAPTURE_SLOPE, CAPTURE_PRE_SAMPLES, CAPTURE_POST_SAMPLES);
+	ADC_SetSampleCallback(CAPTURE_CHANNEL, &Capture_Sample);
+}
+
+/**
+*
+* @brief Check for a captured burst
+*
+* @return true: burst ready for upload
+*/
+bool captureAvailable(void)
+{
+	return Capture_GetState() == CAPTURE_READY;
+}
+
+/**
+*
+* @brief Format the captured burst as POST body
+*
+* Format: "pre=16&samples=512,514,...". pre is the index of the trigger sample.
+* Samples which do not fit into the body are left out.
+*
+* @param body output buffer
+* @param size size of the output buffer
+*
+* @return length of the body
+*/
+uint16_t captureFormatBody(char *body, uint16_t size)
+{
+	char number[6];
+	uint16_t len;
+	uint8_t count = Capture_GetLength();
+	
+	if(size < 32)
+	return 0;
+	
+	strcpy(body, "pre=");
+	utoa(Capture_GetPreTrigger(), &body[4], 10);
+	len = strlen(body);
+	strcpy(&body[len], "&samples=");
+	len += 9;
+	
+	for(uint8_t i = 0; i < count; i++)
+	{
+		utoa(Capture_GetSample(i), number, 10);
+		uint8_t numberLen = strlen(number);
+		
+		if(len + numberLen + 1 > size)
+		break;
+		
+		if(i > 0)
+		body[len++] = ',';
+		
+		memcpy(&body[len], number, numberLen);
+		len += numberLen;
+	}
+	
+	return len;
+}
+
+/**
+*
+* @brief Release the uploaded burst and arm the capture again
+*
+* @return void
+*/
+void captureRelease(void)
+{
+	Capture_Arm();
+}
@@ -0,0 +1,239 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file logRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Local log on the SDcard
+ *
+ * While the datalogger runs, a scheduler task appends the values of the scan list
+ * every LOG_PERIOD as CSV line to LOG_FILE:
+ *
+ * ms,ch1,ch2
+ * 120020,512.250,3.500
+ *
+ * The first column is the time of the values in milliseconds since the start of the
+ * datalogger. The lines are collected in a RAM buffer of LOG_BUFFER_SIZE bytes and
+ * appended together (one sector read and write, a second write at a sector boundary); a
+ * buffer of a whole sector does not fit into the RAM next to the packet buffer. The size
+ * in the directory entry is updated every LOG_SYNC_COUNT lines and when the logging stops.
+ *
+ * The task also runs in Scheduler_Yield() during network waits. The ADC ring buffer is
+ * drained right before a write, which has to finish within ADC_BUFFER_SIZE - 1 frames
+ * (35 ms at 200 Hz). Cards with a longer write busy time drop frames (ADC_GetDroppedFrames).
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "logRoutine.h"
+#include "measureRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include "../libs/sdcard/sdcard.h"
+#include "../libs/scheduler/scheduler.h"
+#include "../libs/timebase/timebase.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LOG_LINE_SIZE		(11 + ADC_SCAN_MAX_CHANNELS * (MEASURE_VALUE_SIZE + 1) + 2)	/**< max. size of one line "ms,value,...\r\n" */
+
+#if LOG_BUFFER_SIZE < LOG_LINE_SIZE
+#error "LOG_BUFFER_SIZE has to hold one line"
+#endif
+
+static int8_t taskId = -1;				/**< scheduler task of the log				*/
+static uint16_t unsynced = 0;			/**< lines since the last directory update	*/
+static char buffer[LOG_BUFFER_SIZE];	/**< lines not written yet					*/
+static uint16_t buffered = 0;			/**< used bytes of the buffer				*/
+static bool running = false;			/**< log file open							*/
+static bool failed = false;				/**< write error since the start			*/
+
+/**
+*
+* @brief Register the log task (stopped)
+*
+* @return void
+*/
+void logInit(void)
+{
+	taskId = Scheduler_AddTask(&logTask, 0);
+}
+
+/**
+*
+* @brief Write the buffered lines to the log file
+*
+* @return true: lines written | false: write error
+*/
+static bool logFlush(void)
+{
+	if(buffered == 0)
+	return true;
+	
+	if(appendFile(buffer, buffered) != 0)
+	return false;
+	
+	buffered = 0;
+	
+	return true;
+}
+
+/**
+*
+* @brief Open the log file and start the logging
+*
+* A new file starts with a header line.
+*
+* @return true: logging started | false: disabled, no SDcard or file error
+*/
+bool logStart(void)
+{
+	#ifdef SD_LOG
+	char fileName[12] = LOG_FILE;
+	char header[LOG_LINE_SIZE];
+	char *pos = header;
+	
+	if(taskId < 0)
+	return false;
+	
+	if(SDInit() == SD_FAIL || getBootSectorData())
+	return false;
+	
+	if(openAppendFile(fileName) != 0)
+	return false;
+	
+	if(_fileSize == 0)
+	{
+		strcpy(pos, "ms");
+		pos += 2;
+		
+		for(uint8_t i = 0; i < ADC_GetScanChannelCount(); i++)
+		{
+			strcpy(pos, ",ch");
+			pos += 3;
+			*pos++ = '1' + i;
+		}
+		
+		*pos++ = '\r';
+		*pos++ = '\n';
+		
+		if(appendFile(header, pos - header) != 0)
+		return false;
+	}
+	
+	unsynced = 0;
+	buffered = 0;
+	failed = false;
+	running = true;
+	Scheduler_SetPeriod(taskId, LOG_PERIOD);
+	
+	return true;
+	#else
+	return false;
+	#endif
+}
+
+/**
+*
+* @brief Stop the logging and write the buffered lines and the file size
+*
+* After a write error the buffered lines are dropped, the written part of the
+* log stays valid.
+*
+* @return true: log complete (or disabled) | false: write error during the run or at the end
+*/
+bool logStop(void)
+{
+	if(!running)
+	return !failed;
+	
+	running = false;
+	Scheduler_SetPeriod(taskId, 0);
+	
+	if(!failed && !logFlush())
+	failed = true;
+	
+	if(closeAppendFile() != 0)
+	failed = true;
+	
+	buffered = 0;
+	
+	return !failed;
+}
+
+/**
+*
+* @brief Log task
+*
+* Scheduler task, adds the current values every LOG_PERIOD to the buffer. A write
+* error (card removed or full) stops the logging, logStop() reports it.
+*
+* @return void
+*/
+void logTask(void)
+{
+	uint16_t values[ADC_SCAN_COUNT];
+	uint32_t timestamp;
+	char line[LOG_LINE_SIZE];
+	char *pos;
+	
+	measureRoutine(values, &timestamp);
+	
+	// time of the values on the millisecond clock
+	ultoa(Timebase_Millis() - (Timebase_Ticks() - timestamp) / TIMEBASE_TICKS_PER_MS, line, 10);
+	pos = line + strlen(line);
+	
+	for(uint8_t i = 0; i < ADC_GetScanChannelCount(); i++)
+	{
+		*pos++ = ',';
+		pos = measureFormatValue(i, values[i], pos);
+	}
+	
+	*pos++ = '\r';
+	*pos++ = '\n';
+	
+	uint8_t length = pos - line;
+	
+	// buffer full: write it before the values are added
+	if(buffered + length > LOG_BUFFER_SIZE && !logFlush())
+	{
+		failed = true;
+		logStop();
+		return;
+	}
+	
+	memcpy(&buffer[buffered], line, length);
+	buffered += length;
+	
+	// the file size covers the written lines only
+	if(++unsynced >= LOG_SYNC_COUNT)
+	{
+		unsynced = 0;
+		
+		if(!logFlush() || syncAppendFile() != 0)
+		{
+			failed = true;
+			logStop();
+		}
+	}
+}
@@ -36,19 +36,322 @@
 #include "measureRoutine.h"
 #include "../ioconfig.h"
 #include "../libs/adc/adc.h"
+#include "../libs/filter/filter.h"
+#include <avr/pgmspace.h>
+
+#define MEASURE_CHANNELS	ADC_SCAN_COUNT	/**< count of channels in the scan list */
+
+static const ADC_ScanChannel scanChannels[MEASURE_CHANNELS] PROGMEM = ADC_SCAN_CHANNELS;	/**< scan list (ioconfig.h) */
+
+static const FilterConfig filterConfig[MEASURE_CHANNELS][FILTER_MAX_STAGES] PROGMEM = ADC_FILTER_CHANNELS;	/**< filters (ioconfig.h) */
+
+static FilterChain filters[MEASURE_CHANNELS];			/**< filter chain of every channel			*/
+static StatAccumulator statistics[MEASURE_CHANNELS];	/**< statistics of the current interval		*/
+static uint16_t lastValues[MEASURE_CHANNELS];			/**< filtered values of the newest frame	*/
+static uint32_t lastTimestamp = 0;						/**< timestamp of the newest frame			*/
+
+#ifdef DEBUG_MODE
+static uint16_t filterTicksMin = 0xFFFF;				/**< min. filter time of a frame (Timer1 ticks)	*/
+static uint16_t filterTicksMax = 0;						/**< max. filter time of a frame (Timer1 ticks)	*/
+#endif
+
+/**
+*
+* @brief Start background measurement
+*
+* Configure the ADC scan list and the filter chains and start the Timer1 triggered
+* scans with ADC_SAMPLE_RATE.
+*
+* @return void
+*/
+void measureInit(void)
+{
+	FilterConfig config[FILTER_MAX_STAGES];
+	ADC_ScanChannel channels[MEASURE_CHANNELS];
+	
+	// the tables are kept in flash
+	for(uint8_t i = 0; i < MEASURE_CHANNELS; i++)
+	{
+		memcpy_P(config, filterConfig[i], sizeof(config));
+		Filter_Init(&filters[i], config);
+		Stat_Reset(&statistics[i]);
+	}
+	
+	memcpy_P(channels, scanChannels, sizeof(channels));
+	ADC_ScanConfigure(channels, MEASURE_CHANNELS);
+	
+	ADC_StartTriggered(ADC_TRIGGER_TIMER1, (uint16_t)(F_CPU / 8 / ADC_SAMPLE_RATE));
+}
+
+/**
+*
+* @brief Process the frames scanned in background
+*
+* All frames since the last call are drained out of the ADC ring buffer. Every value
+* passes the filter chain of its channel and is added to the statistics of the
+* current interval. This function is called frequently by the sampling task (measureTask),
+* otherwise frames are dropped when the ring buffer is full.
+*
+* @return void
+*/
+void measurePoll(void)
+{
+	ADC_Frame frame;
+	uint8_t channels = ADC_GetScanChannelCount();
+	
+	while(ADC_PopFrame(&frame))
+	{
+		#ifdef DEBUG_MODE
+		uint16_t start = TCNT1;
+		for(uint8_t i = 0; i < channels; i++)
+		lastValues[i] = Filter_Process(&filters[i], frame.value[i]);
+		uint16_t ticks = TCNT1 - start;
+		
+		if(ticks < filterTicksMin) filterTicksMin = ticks;
+		if(ticks > filterTicksMax) filterTicksMax = ticks;
+		#else
+		for(uint8_t i = 0; i < channels; i++)
+		lastValues[i] = Filter_Process(&filters[i], frame.value[i]);
+		#endif
+		
+		for(uint8_t i = 0; i < channels; i++)
+		Stat_Add(&statistics[i], lastValues[i]);
+		
+		lastTimestamp = frame.timestamp;
+	}
+}
+
+#ifdef DEBUG_MODE
+/**
+*
+* @brief Read the processing time of the filter chains
+*
+* Time of all filter chains of a frame in Timer1 ticks (F_CPU/8, 8 CPU cycles). The
+* minimum is the cost without interrupts, the maximum includes the ADC and timer
+* interrupts during the filtering.
+*
+* @param min output of the min. time per frame
+* @param max output of the max. time per frame
+*
+* @return void
+*/
+void measureFilterTicks(uint16_t *min, uint16_t *max)
+{
+	*min = filterTicksMin;
+	*max = filterTicksMax;
+}
+
+#endif
+
+/**
+*
+* @brief Sampling task
+*
+* Scheduler task, drains the ADC ring buffer every MEASURE_POLL_PERIOD.
+*
+* @return void
+*/
+void measureTask(void)
+{
+	measurePoll();
+}
 
 /**
 *
 * @brief Measurement routines
 *
-* read ADC values (0...1023)
-* value will be returned without conversions.
+* read ADC values (0...2^(10+n)-1, n = extra bits of the channel)
+* Pending frames are processed, the filtered values of the newest frame will be returned.
+* If no frame was scanned yet, the measurement values are 0.
+*
+* @param measureValues Pointer of measurement values (one per channel of the scan list)
+* @param timestamp Pointer for the timestamp of the values (Timebase ticks)
+*
+* @return void
+*/
+void measureRoutine(uint16_t *measureValues, uint32_t *timestamp)
+{
+	uint8_t channels = ADC_GetScanChannelCount();
+	
+	measurePoll();
+	
+	for(uint8_t i = 0; i < channels; i++)
+	measureValues[i] = lastValues[i];
+	
+	*timestamp = lastTimestamp;
+}
+
+/**
+*
+* @brief Statistics of the current interval
+*
+* Pending frames are processed, then min, max, mean and standard deviation of every
+* channel are calculated. The interval goes on until measureStatisticsReset(), so an
+* interval that is not reported is part of the next one.
+*
+* @param results Pointer of the statistics (one per channel of the scan list)
+*
+* @return void
+*/
+void measureStatistics(StatResult *results)
+{
+	uint8_t channels = ADC_GetScanChannelCount();
+	
+	measurePoll();
+	
+	for(uint8_t i = 0; i < channels; i++)
+	Stat_Result(&statistics[i], &results[i]);
+}
+
+/**
+*
+* @brief Start a new statistics interval
+*
+* Call after the statistics were reported and at the start of a run.
+*
+* @return void
+*/
+void measureStatisticsReset(void)
+{
+	measurePoll();
+	
+	for(uint8_t i = 0; i < MEASURE_CHANNELS; i++)
+	Stat_Reset(&statistics[i]);
+}
+
+/**
+*
+* @brief Format a measurement value as decimal number
+*
+* The value is scaled to the 10 bit range (0...1023). Extra bits of oversampled
+* channels are written as 3 decimal places, e.g. 2049 with 2 extra bits -> "512.250".
+*
+* @param value measurement value with 10+extraBits bits
+* @param extraBits additional bits of the channel
+* @param str output string
+*
+* @return pointer to the end of the string
+*/
+static char* measureFormatFixed(uint16_t value, uint8_t extraBits, char *str)
+{
+	utoa(value >> extraBits, str, 10);
+	str += strlen(str);
+	
+	if(extraBits == 0)
+	return str;
+	
+	// fraction in 1/1000
+	uint16_t fraction = (uint16_t)(((uint32_t)(value & ((1 << extraBits) - 1)) * 1000) >> extraBits);
+	
+	*str++ = '.';
+	*str++ = '0' + fraction / 100;
+	*str++ = '0' + (fraction / 10) % 10;
+	*str++ = '0' + fraction % 10;
+	*str = '\0';
+	
+	return str;
+}
+
+/**
+*
+* @brief Format the value of a channel as decimal number
+*
+* @param channel index of the channel in the scan list
+* @param value measurement value of the channel
+* @param str output string (min. MEASURE_VALUE_SIZE characters)
+*
+* @return pointer to the end of the string
+*/
+char* measureFormatValue(uint8_t channel, uint16_t value, char *str)
+{
+	uint8_t extraBits = (channel < MEASURE_CHANNELS) ? pgm_read_byte(&scanChannels[channel].extraBits) : 0;
+	
+	return measureFormatFixed(value, extraBits, str);
+}
+
+/**
+*
+* @brief Format a URL parameter name
+*
+* The first field is part of the URL, every further field is written as "&fieldN=".
+*
+* @param field field number (1...MEASURE_MAX_FIELDS)
+* @param str output string
+*
+* @return pointer to the end of the string
+*/
+static char* measureFormatField(uint8_t field, char *str)
+{
+	if(field == 1)
+	return str;
+	
+	strcpy_P(str, PSTR("&field"));
+	str += 6;
+	utoa(field, str, 10);
+	str += strlen(str);
+	*str++ = '=';
+	*str = '\0';
+	
+	return str;
+}
+
+/**
+*
+* @brief Format measurement values for the GET request
+*
+* The values are written as URL parameters field1...fieldN. The URL has to end
+* with the name of the first field, e.g. "...&field1=" -> "512&field2=100.250".
+*
+* @param measureValues Pointer of measurement values
+* @param str output string (min. MEASURE_STRING_SIZE characters)
+*
+* @return void
+*/
+void measureFormatValues(uint16_t *measureValues, char *str)
+{
+	uint8_t channels = ADC_GetScanChannelCount();
+	
+	char *pos = str;
+	
+	*pos = '\0';
+	
+	for(uint8_t i = 0; i < channels && i < MEASURE_MAX_FIELDS; i++)
+	{
+		pos = measureFormatField(i + 1, pos);
+		pos = measureFormatValue(i, measureValues[i], pos);
+	}
+}
+
+/**
+*
+* @brief Format interval statistics for the GET request
+*
+* Every channel uses 4 fields in the order mean, min, max and standard deviation,
+* e.g. channel 1: field1...field4, channel 2: field5...field8.
+* Fields above MEASURE_MAX_FIELDS are not transmitted.
 *
-* @param measureValue Pointer of measurement value
+* @param results Pointer of the statistics
+* @param str output string (min. MEASURE_STRING_SIZE characters)
 *
 * @return void
 */
-void measureRoutine(uint16_t *measureValue)
+void measureFormatStatistics(StatResult *results, char *str)
 {
-	*measureValue = ADC_Read(ADC_CHANNEL);
-}
\ No newline at end of file
+	uint8_t channels = ADC_GetScanChannelCount();
+	uint8_t field = 1;
+	
+	char *pos = str;
+	
+	*pos = '\0';
+	
+	for(uint8_t i = 0; i < channels && field + 3 <= MEASURE_MAX_FIELDS; i++)
+	{
+		uint16_t values[4] = {results[i].mean, results[i].min, results[i].max, results[i].stddev};
+		
+		for(uint8_t j = 0; j < 4; j++)
+		{
+			pos = measureFormatField(field++, pos);
+			pos = measureFormatValue(i, values[j], pos);
+		}
+	}
+}
@@ -32,7 +32,34 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-void measureRoutine(uint16_t *measureValue);
+#include "../libs/statistics/statistics.h"
+
+#define MEASURE_MAX_FIELDS	8		/**< max. count of transmitted fields (thingspeak: field1...field8)	*/
+#define MEASURE_STRING_SIZE	144		/**< size of the string for formatted measurement values			*/
+#define MEASURE_VALUE_SIZE	9		/**< max. size of a formatted value ("65535.999")					*/
+#define MEASURE_POLL_PERIOD	20		/**< period of the sampling task in ms (< ADC_BUFFER_SIZE scans)	*/
+
+void measureInit(void);
+
+void measurePoll(void);
+
+void measureTask(void);
+
+#ifdef DEBUG_MODE
+void measureFilterTicks(uint16_t *min, uint16_t *max);
+#endif
+
+void measureRoutine(uint16_t *measureValues, uint32_t *timestamp);
+
+void measureStatistics(StatResult *results);
+
+void measureStatisticsReset(void);
+
+void measureFormatValues(uint16_t *measureValues, char *str);
+
+void measureFormatStatistics(StatResult *results, char *str);
+
+char* measureFormatValue(uint8_t channel, uint16_t value, char *str);
 
 
 
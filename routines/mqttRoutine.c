@@ -0,0 +1,198 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file mqttRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief MQTT publish routine
+ *
+ * The values of a send slot are published with QoS 0 to MQTT_TOPIC/chN (with
+ * statistics: MQTT_TOPIC/chN/mean, /min, /max, /std) over one persistent TCP
+ * connection. A new connection starts with CONNECT in the same segment. Older values
+ * (from the spool) are followed by their age in seconds on MQTT_TOPIC/age, there is no
+ * wall clock for a timestamp.
+ *
+ * The TCP client of the network stack expects an answer to every request, QoS 0
+ * publishes are not answered by the broker. So every segment ends with a PINGREQ:
+ * the PINGRESP (or CONNACK) completes the request and keeps the session alive.
+ * Without values a PINGREQ is sent alone, if the keep alive interval is half over.
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "mqttRoutine.h"
+#include "measureRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include "../libs/mqtt/mqtt.h"
+#include "../libs/timebase/timebase.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char mqttSuffix[4][6] PROGMEM = {"/mean", "/min", "/max", "/std"};	/**< topics of the statistic values */
+
+static uint16_t *sampleValues = NULL;	/**< values of the next publish (NULL: ping only)	*/
+static StatResult *sampleStats = NULL;	/**< statistics of the next publish					*/
+static uint32_t sampleAge = 0;			/**< age of the values in seconds					*/
+static bool connected = false;			/**< session accepted by the broker					*/
+static uint32_t lastSend = 0;			/**< time of the last segment (Timebase_Millis)		*/
+
+/**
+*
+* @brief Set the values of the next publish
+*
+* @param values measurement values (used without statistics, NULL: ping only)
+* @param stats statistics of the interval (NULL: publish the values)
+* @param age age of the values in seconds (0: current values, no age is published)
+*
+* @return void
+*/
+void mqttSet(uint16_t *values, StatResult *stats, uint32_t age)
+{
+	sampleValues = values;
+	sampleStats = stats;
+	sampleAge = age;
+}
+
+/**
+*
+* @brief Format the topic of a value
+*
+* @param channel index of the channel in the scan list
+* @param statistic index of the statistic value (0...3) or 4 without statistics
+* @param str output string (min. MQTT_TOPIC_SIZE characters)
+*
+* @return void
+*/
+static void mqttFormatTopic(uint8_t channel, uint8_t statistic, char *str)
+{
+	strcpy_P(str, PSTR(MQTT_TOPIC "/ch"));
+	str += strlen(str);
+	utoa(channel + 1, str, 10);
+	
+	if(statistic < 4)
+	strcat_P(str, mqttSuffix[statistic]);
+}
+
+/**
+*
+* @brief Format the TCP data
+*
+* Values that don't fit into the packet anymore are not published.
+*
+* @param data output buffer (packet buffer)
+* @param size size of the buffer
+* @param reused true: the session is open | false: new connection
+*
+* @return length of the data
+*/
+uint16_t mqttFormat(char *data, uint16_t size, bool reused)
+{
+	uint8_t *pos = (uint8_t*)data;
+	uint8_t *end = pos + size - MQTT_PINGREQ_SIZE;
+	
+	lastSend = Timebase_Millis();
+	
+	if(!reused)
+	{
+		char clientId[sizeof(MQTT_CLIENT_ID)];
+		strcpy_P(clientId, PSTR(MQTT_CLIENT_ID));
+		pos += MQTT_Connect(pos, end - pos, clientId, MQTT_KEEPALIVE);
+	}
+	
+	if(sampleValues != NULL)
+	{
+		uint8_t channels = ADC_GetScanChannelCount();
+		uint8_t count = (sampleStats != NULL) ? 4 : 1;
+		
+		char topic[MQTT_TOPIC_SIZE];
+		char value[MEASURE_VALUE_SIZE + 1];
+		
+		for(uint8_t i = 0; i < channels; i++)
+		{
+			for(uint8_t j = 0; j < count; j++)
+			{
+				uint16_t sample;
+				if(sampleStats == NULL)
+				sample = sampleValues[i];
+				else if(j == 0)
+				sample = sampleStats[i].mean;
+				else if(j == 1)
+				sample = sampleStats[i].min;
+				else if(j == 2)
+				sample = sampleStats[i].max;
+				else
+				sample = sampleStats[i].stddev;
+				
+				mqttFormatTopic(i, (sampleStats != NULL) ? j : 4, topic);
+				uint16_t length = measureFormatValue(i, sample, value) - value;
+				
+				uint16_t packet = MQTT_Publish(pos, end - pos, topic, value, length);
+				if(packet == 0)
+				break;
+				
+				pos += packet;
+			}
+		}
+		
+		if(sampleAge != 0)
+		{
+			char age[11];
+			strcpy_P(topic, PSTR(MQTT_TOPIC "/age"));
+			ultoa(sampleAge, age, 10);
+			pos += MQTT_Publish(pos, end - pos, topic, age, strlen(age));
+		}
+	}
+	
+	pos += MQTT_PingReq(pos, MQTT_PINGREQ_SIZE);
+	
+	return (char*)pos - data;
+}
+
+/**
+*
+* @brief Check the answer of the broker
+*
+* @param data first data of the answer
+* @param length length of the data
+*
+* @return true: session ok | false: refused (the connection is closed)
+*/
+bool mqttAnswer(char *data, uint16_t length)
+{
+	connected = (MQTT_CheckAnswer((uint8_t*)data, length) == MQTT_ANSWER_OK);
+	
+	return connected;
+}
+
+/**
+*
+* @brief Check if the session needs a PINGREQ
+*
+* @return true: half of the keep alive interval without segment
+*/
+bool mqttPingDue(void)
+{
+	return connected && Timebase_Millis() - lastSend >= (uint32_t)MQTT_KEEPALIVE * 500;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file mqttRoutine.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef MQTT_ROUTINE_H_
+#define MQTT_ROUTINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../libs/statistics/statistics.h"
+
+#define MQTT_TOPIC_SIZE		32		/**< max. size of a topic name ("datalogger/ch1/mean")	*/
+
+void mqttSet(uint16_t *values, StatResult *stats, uint32_t age);
+
+uint16_t mqttFormat(char *data, uint16_t size, bool reused);
+
+bool mqttAnswer(char *data, uint16_t length);
+
+bool mqttPingDue(void);
+
+#endif /* MQTT_ROUTINE_H_ */
\ No newline at end of file
@@ -0,0 +1,135 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file reportRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Reporting policy (send on change)
+ *
+ * Decide whether the measurement values of an interval are transmitted. Values are only
+ * sent if one of the current values leaves the absolute or relative deadband around the
+ * value at the last transmission. The decision uses the current values, not the statistics
+ * of the interval: these include the suppressed intervals and react late to a step. A heartbeat transmission is forced after REPORT_HEARTBEAT seconds without
+ * transmission.
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "reportRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+
+static uint16_t reportedValues[ADC_SCAN_COUNT];			/**< last transmitted values					*/
+static uint32_t silence = 0;							/**< seconds since the last transmission		*/
+static bool reported = false;							/**< values transmitted at least once			*/
+
+/**
+*
+* @brief Reset the reporting policy
+*
+* The next call of reportRoutine() requests a transmission.
+*
+* @return void
+*/
+void reportInit(void)
+{
+	reported = false;
+	silence = 0;
+}
+
+/**
+*
+* @brief Check if a value left the deadband
+*
+* @param value current value
+* @param reference last transmitted value
+*
+* @return true: value outside of the deadband
+*/
+static bool reportOutsideDeadband(uint16_t value, uint16_t reference)
+{
+	uint16_t delta = (value > reference) ? value - reference : reference - value;
+	
+	// deadband disabled -> every value is a change
+	if(REPORT_DEADBAND_ABS == 0 && REPORT_DEADBAND_REL == 0)
+	return true;
+	
+	if(REPORT_DEADBAND_ABS != 0 && delta > REPORT_DEADBAND_ABS)
+	return true;
+	
+	if(REPORT_DEADBAND_REL != 0 && (uint32_t)delta * 100 > (uint32_t)reference * REPORT_DEADBAND_REL)
+	return true;
+	
+	return false;
+}
+
+/**
+*
+* @brief Reporting routine
+*
+* @param values current measurement values
+* @param count count of values
+* @param elapsed seconds since the last call
+*
+* @return true: transmit the values | false: values inside the deadband
+*/
+bool reportRoutine(uint16_t *values, uint8_t count, uint32_t elapsed)
+{
+	silence += elapsed;
+	
+	if(!reported)
+	return true;
+	
+	// heartbeat
+	if(silence >= REPORT_HEARTBEAT)
+	return true;
+	
+	for(uint8_t i = 0; i < count && i < ADC_SCAN_COUNT; i++)
+	{
+		if(reportOutsideDeadband(values[i], reportedValues[i]))
+		return true;
+	}
+	
+	return false;
+}
+
+/**
+*
+* @brief Store transmitted values
+*
+* Call after a transmission to move the deadband to the new values.
+*
+* @param values current measurement values at the transmission (as for reportRoutine())
+* @param count count of values
+*
+* @return void
+*/
+void reportSent(uint16_t *values, uint8_t count)
+{
+	for(uint8_t i = 0; i < count && i < ADC_SCAN_COUNT; i++)
+	reportedValues[i] = values[i];
+	
+	reported = true;
+	silence = 0;
+}
@@ -27,12 +27,26 @@
  *
  * @brief Datalogger countdown routine
  *
+ * The send slots are absolute deadlines on the monotonic timebase. The next deadline
+ * is calculated from the previous deadline, not from the end of the upload, so the
+ * long-run send rate is exact.
  *
+ * Missed slots (upload took longer than the interval) are handled by RUN_MISSED_SLOTS:
+ * RUN_SKIP continues with the next slot in the future, RUN_CATCHUP sends the missed
+ * slots immediately one after the other (max. RUN_MAX_CATCHUP, older slots are skipped).
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
 */
 
 #include "runRoutine.h"
+#include "../ioconfig.h"
 
 #include "../libs/delay/delay.h"
+#include "../libs/timebase/timebase.h"
+
+static uint32_t deadline = 0;		/**< next send slot (Timebase_Millis)		*/
+static uint32_t period = 0;			/**< send interval in milliseconds			*/
+static uint32_t missedSlots = 0;	/**< count of skipped send slots			*/
 
 
 /**
@@ -50,4 +64,97 @@ void runRoutine(bool *pulse1s, uint32_t *sec_until_send)
 {
 	if(*pulse1s) *sec_until_send-=1;
 	
-}
\ No newline at end of file
+}
+
+/**
+*
+* @brief Start the send schedule
+*
+* The first send slot is one interval after the start.
+*
+* @param interval send interval in seconds
+*
+* @return void
+*/
+void runStart(uint32_t interval)
+{
+	period = interval * 1000;
+	deadline = Timebase_Millis() + period;
+	missedSlots = 0;
+}
+
+/**
+*
+* @brief Check the send slot
+*
+* @return true: deadline of the send slot reached
+*/
+bool runDue(void)
+{
+	return (int32_t)(Timebase_Millis() - deadline) >= 0;
+}
+
+/**
+*
+* @brief Move the schedule to the next send slot
+*
+* Call once when a due slot gets processed.
+*
+* @return count of intervals covered by the processed slot (1 + skipped slots)
+*/
+uint32_t runAdvance(void)
+{
+	uint32_t now = Timebase_Millis();
+	uint32_t slots = 1;
+	
+	if(period == 0)
+	{
+		deadline = now;
+		return slots;
+	}
+	
+	deadline += period;
+	
+	// intervals behind the schedule
+	uint32_t behind = ((int32_t)(now - deadline) >= 0) ? (now - deadline) / period + 1 : 0;
+	
+	#if RUN_MISSED_SLOTS == RUN_CATCHUP
+	if(behind <= RUN_MAX_CATCHUP)
+	behind = 0;
+	else
+	behind -= RUN_MAX_CATCHUP;
+	#endif
+	
+	deadline += behind * period;
+	missedSlots += behind;
+	slots += behind;
+	
+	return slots;
+}
+
+/**
+*
+* @brief Time until the next send slot
+*
+* @return seconds until the next send slot (rounded up)
+*/
+uint32_t runSecondsLeft(void)
+{
+	int32_t left = (int32_t)(deadline - Timebase_Millis());
+	
+	if(left <= 0)
+	return 0;
+	
+	return ((uint32_t)left + 999) / 1000;
+}
+
+/**
+*
+* @brief Count of skipped send slots since runStart()
+*
+* @return skipped slots
+*/
+uint32_t runMissedSlots(void)
+{
+	return missedSlots;
+}
@@ -32,6 +32,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#define RUN_SKIP		0	/**< missed send slots: continue with the next slot in the future	*/
+#define RUN_CATCHUP		1	/**< missed send slots: send them immediately						*/
+
 void runRoutine(bool *pulse1s, uint32_t *sec_until_send);
 
+void runStart(uint32_t interval);
+
+bool runDue(void);
+
+uint32_t runAdvance(void);
+
+uint32_t runSecondsLeft(void);
+
+uint32_t runMissedSlots(void);
+
 #endif /* RUNROUTINE_H_ */
\ No newline at end of file
@@ -0,0 +1,363 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file spoolRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Store-and-forward spool on the SDcard
+ *
+ * Samples which could not be sent are kept in a ring buffer (FIFO) inside the file
+ * SPOOL_FILE and sent later, oldest first. The file is written sector by sector
+ * without changes of the FAT, therefore it has to exist and be contiguous (eg. created
+ * on a freshly formatted card). The file size defines the capacity, a full spool
+ * overwrites the oldest sample.
+ *
+ * Sector 0 of the file holds the header (write position and count), the following
+ * sectors hold the records. The time of a record is the uptime in seconds, which only
+ * counts within one power-up: the header counts the power-ups and every record keeps the
+ * number of its power-up. Records of an earlier power-up are dated to the reset (time 0),
+ * the lower bound of their age.
+ * The header is written with every new sample; after a
+ * drain only once, a power loss during a drain can repeat up to SPOOL_DRAIN_COUNT samples.
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "spoolRoutine.h"
+#include "runRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include "../libs/sdcard/sdcard.h"
+#include "../libs/sdcard/definitions.h"
+#include "../libs/timebase/timebase.h"
+#include <string.h>
+
+#define SPOOL_MAGIC			0x324C5053UL	/**< "SPL2" at the start of the header sector	*/
+
+/**
+*
+* @brief Spooled sample
+*
+*/
+typedef struct{
+	uint32_t seconds;							/**< time of the sample in seconds		*/
+	uint16_t boot;								/**< power-up of the sample				*/
+	uint16_t values[ADC_SCAN_MAX_CHANNELS];		/**< values of the scan list			*/
+}SpoolRecord;
+
+/**
+*
+* @brief Header sector of the spool file
+*
+*/
+typedef struct{
+	uint32_t magic;			/**< SPOOL_MAGIC						*/
+	uint32_t capacity;		/**< max. count of records				*/
+	uint32_t head;			/**< index of the next record to write	*/
+	uint32_t count;			/**< count of stored records			*/
+	uint16_t boot;			/**< count of power-ups					*/
+}SpoolHeader;
+
+#define SPOOL_PER_SECTOR	(512 / sizeof(SpoolRecord))	/**< records per sector */
+
+static uint32_t headerSector = 0;	/**< first sector of the spool file (0: spool not available)	*/
+static uint32_t capacity = 0;		/**< max. count of records									*/
+static uint32_t head = 0;			/**< index of the next record to write						*/
+static uint32_t count = 0;			/**< count of stored records								*/
+static bool dirty = false;			/**< records removed since the last header write			*/
+static bool drainEnabled = false;	/**< spool is emptied by spoolDrainDue()/STATE_DRAIN			*/
+static bool linkUp = true;			/**< last transmission was successful						*/
+static uint32_t lastDrain = 0;		/**< time of the last drain (Timebase_Millis)				*/
+static uint16_t boot = 0;			/**< power-up of the new records (0: not counted yet)		*/
+
+/**
+*
+* @brief Read a sector of the spool file to _SDBuffer
+*
+* @param sector sector on the SDcard
+*
+* @return true: sector read | false: read error
+*/
+static bool spoolRead(uint32_t sector)
+{
+	uint8_t token;
+	uint8_t res = SDReadBlock(sector, &token);
+	
+	return SD_R1_NO_ERROR(res) && token == SD_START_TOKEN;
+}
+
+/**
+*
+* @brief Write _SDBuffer to a sector of the spool file
+*
+* A write error disables the spool (eg. card removed).
+*
+* @param sector sector on the SDcard
+*
+* @return true: sector written | false: write error
+*/
+static bool spoolWrite(uint32_t sector)
+{
+	uint8_t token;
+	uint8_t res = SDWriteBlock(sector, &token);
+	
+	if(res == SD_READY && token == SD_DATA_ACCEPTED)
+	return true;
+	
+	headerSector = 0;
+	return false;
+}
+
+/**
+*
+* @brief Write the header sector
+*
+* @return true: header written | false: write error
+*/
+static bool spoolWriteHeader(void)
+{
+	SpoolHeader *header = (SpoolHeader *)_SDBuffer;
+	
+	memset((uint8_t *)_SDBuffer, 0, 512);
+	header->magic = SPOOL_MAGIC;
+	header->capacity = capacity;
+	header->head = head;
+	header->count = count;
+	header->boot = boot;
+	
+	dirty = false;
+	
+	return spoolWrite(headerSector);
+}
+
+/**
+*
+* @brief Open the spool file
+*
+* Samples of an earlier run stay in the spool. A file without valid header (new
+* or resized file) starts empty.
+*
+* @param drain true: samples are sent by STATE_DRAIN | false: samples are taken
+* by the caller with spoolPeek()/spoolPop()
+*
+* @return true: spool available | false: no SDcard, no file or file not contiguous
+*/
+bool spoolInit(bool drain)
+{
+	headerSector = 0;
+	drainEnabled = drain;
+	linkUp = true;
+	lastDrain = Timebase_Millis();
+	
+	#ifdef SD_SPOOL
+	char fileName[12] = SPOOL_FILE;
+	uint32_t sector, size;
+	
+	if(SDInit() == SD_FAIL || getBootSectorData())
+	return false;
+	
+	if(getContiguousFile(fileName, &sector, &size) != 0 || size < 2 * 512)
+	return false;
+	
+	if(!spoolRead(sector))
+	return false;
+	
+	SpoolHeader *header = (SpoolHeader *)_SDBuffer;
+	
+	headerSector = sector;
+	capacity = (size / 512 - 1) * SPOOL_PER_SECTOR;
+	
+	if(header->magic == SPOOL_MAGIC && header->capacity == capacity && header->head < capacity && header->count <= capacity)
+	{
+		head = header->head;
+		count = header->count;
+		dirty = false;
+		
+		if(boot != 0)
+		return true;
+		
+		// first run since the reset: a new power-up
+		boot = header->boot + 1;
+		if(boot == 0)
+		boot = 1;
+		
+		return spoolWriteHeader();
+	}
+	
+	head = 0;
+	count = 0;
+	if(boot == 0)
+	boot = 1;
+	
+	return spoolWriteHeader();
+	#else
+	return false;
+	#endif
+}
+
+/**
+*
+* @brief Append a sample to the spool
+*
+* @param values measurement values (one per channel of the scan list)
+* @param seconds time of the sample in seconds
+*
+* @return true: sample stored | false: spool not available
+*/
+bool spoolPush(uint16_t *values, uint32_t seconds)
+{
+	if(headerSector == 0)
+	return false;
+	
+	uint32_t sector = headerSector + 1 + head / SPOOL_PER_SECTOR;
+	
+	// the other records of the sector are still valid
+	if(!spoolRead(sector))
+	return false;
+	
+	SpoolRecord *record = &((SpoolRecord *)_SDBuffer)[head % SPOOL_PER_SECTOR];
+	record->seconds = seconds;
+	record->boot = boot;
+	for(uint8_t i = 0; i < ADC_SCAN_MAX_CHANNELS; i++)
+	record->values[i] = values[i];
+	
+	if(!spoolWrite(sector))
+	return false;
+	
+	// full spool: the oldest record was overwritten
+	head = (head + 1) % capacity;
+	if(count < capacity)
+	count++;
+	
+	return spoolWriteHeader();
+}
+
+/**
+*
+* @brief Read a sample of the spool
+*
+* Samples of an earlier power-up get the time 0.
+*
+* @param index position in the spool (0: oldest sample)
+* @param values output for the measurement values
+* @param seconds output for the time of the sample
+*
+* @return true: sample read | false: spool empty or not available
+*/
+bool spoolPeek(uint32_t index, uint16_t *values, uint32_t *seconds)
+{
+	if(headerSector == 0 || index >= count)
+	return false;
+	
+	uint32_t tail = (head + capacity - count + index) % capacity;
+	
+	if(!spoolRead(headerSector + 1 + tail / SPOOL_PER_SECTOR))
+	return false;
+	
+	SpoolRecord *record = &((SpoolRecord *)_SDBuffer)[tail % SPOOL_PER_SECTOR];
+	*seconds = (record->boot == boot) ? record->seconds : 0;
+	for(uint8_t i = 0; i < ADC_SCAN_MAX_CHANNELS; i++)
+	values[i] = record->values[i];
+	
+	return true;
+}
+
+/**
+*
+* @brief Remove the oldest sample (after it was sent)
+*
+* The header is written with spoolCommit().
+*
+* @return void
+*/
+void spoolPop(void)
+{
+	if(count == 0)
+	return;
+	
+	count--;
+	dirty = true;
+}
+
+/**
+*
+* @brief Finish a drain
+*
+* Write the header, if samples were removed, and restart the drain period.
+*
+* @return void
+*/
+void spoolCommit(void)
+{
+	lastDrain = Timebase_Millis();
+	
+	if(dirty && headerSector != 0)
+	spoolWriteHeader();
+}
+
+/**
+*
+* @brief Count of samples in the spool
+*
+* @return count of samples
+*/
+uint32_t spoolCount(void)
+{
+	return (headerSector == 0) ? 0 : count;
+}
+
+/**
+*
+* @brief Report the result of a transmission
+*
+* The spool is only drained after a successful transmission, so a drain does not
+* wait for the timeouts of an unreachable server.
+*
+* @param online true: transmission successful | false: transmission failed
+*
+* @return void
+*/
+void spoolOnline(bool online)
+{
+	linkUp = online;
+}
+
+/**
+*
+* @brief Check if spooled samples should be sent
+*
+* Max. one drain every SPOOL_DRAIN_PERIOD and only with SPOOL_DRAIN_MARGIN seconds
+* left until the next send slot, so the live samples keep their slots.
+*
+* @return true: drain the spool now | false: nothing to do
+*/
+bool spoolDrainDue(void)
+{
+	if(!drainEnabled || !linkUp || spoolCount() == 0)
+	return false;
+	
+	if(Timebase_Millis() - lastDrain < SPOOL_DRAIN_PERIOD)
+	return false;
+	
+	return runSecondsLeft() > SPOOL_DRAIN_MARGIN;
+}
@@ -0,0 +1,196 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file telemetryRoutine.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief UDP telemetry routine
+ *
+ * Formats the values of a send slot as payload of a UDP datagram (UDP_FORMAT):
+ *
+ * TELEMETRY_INFLUX:	datalogger ch1=512.250,ch2=100.000
+ * TELEMETRY_STATSD:	datalogger.ch1:512.250|g
+ *						datalogger.ch2:100.000|g
+ *
+ * With statistics every channel is sent as chN_mean, chN_min, chN_max and chN_std.
+ * The receiver stamps the values with the arrival time. There is no wall clock, so
+ * older values (from the spool) are sent with their age in seconds as additional
+ * value: "age=120i" (influx) or "datalogger.age:120|g" (statsd).
+ *
+ * @note this file need a ioconfig.h in the root direcotry of the project.
+*/
+
+#include "telemetryRoutine.h"
+#include "measureRoutine.h"
+#include "../ioconfig.h"
+#include "../libs/adc/adc.h"
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TELEMETRY_ENTRY_MAX	(sizeof(UDP_MEASUREMENT) + 16 + MEASURE_VALUE_SIZE)	/**< max. size of one value "name.chN_mean:value|g\n" */
+
+static const char telemetrySuffix[4][6] PROGMEM = {"_mean", "_min", "_max", "_std"};	/**< names of the statistic values */
+
+static uint16_t *sampleValues = NULL;	/**< values of the next datagram		*/
+static StatResult *sampleStats = NULL;	/**< statistics of the next datagram	*/
+static uint32_t sampleAge = 0;			/**< age of the values in seconds		*/
+
+/**
+*
+* @brief Set the values of the next datagram
+*
+* @param values measurement values (used without statistics)
+* @param stats statistics of the interval (NULL: send the values)
+* @param age age of the values in seconds (0: current values, no age is sent)
+*
+* @return void
+*/
+void telemetrySet(uint16_t *values, StatResult *stats, uint32_t age)
+{
+	sampleValues = values;
+	sampleStats = stats;
+	sampleAge = age;
+}
+
+/**
+*
+* @brief Format the name of a value
+*
+* @param channel index of the channel in the scan list
+* @param statistic index of the statistic value (0...3) or 4 without statistics
+* @param str output string
+*
+* @return pointer to the end of the string
+*/
+static char* telemetryFormatName(uint8_t channel, uint8_t statistic, char *str)
+{
+	*str++ = 'c';
+	*str++ = 'h';
+	utoa(channel + 1, str, 10);
+	str += strlen(str);
+	
+	if(statistic < 4)
+	{
+		strcpy_P(str, telemetrySuffix[statistic]);
+		str += strlen(str);
+	}
+	
+	return str;
+}
+
+/**
+*
+* @brief Format the datagram payload
+*
+* Values that don't fit into the buffer anymore are not transmitted.
+*
+* @param data output buffer (packet buffer)
+* @param size size of the buffer
+*
+* @return length of the payload
+*/
+uint16_t telemetryFormat(char *data, uint16_t size)
+{
+	uint8_t channels = ADC_GetScanChannelCount();
+	uint8_t count = (sampleStats != NULL) ? 4 : 1;
+	
+	char *pos = data;
+	bool first = true;
+	
+	for(uint8_t i = 0; i < channels; i++)
+	{
+		for(uint8_t j = 0; j < count; j++)
+		{
+			if(size - (uint16_t)(pos - data) < TELEMETRY_ENTRY_MAX)
+			break;
+			
+			uint16_t value;
+			if(sampleStats == NULL)
+			value = sampleValues[i];
+			else if(j == 0)
+			value = sampleStats[i].mean;
+			else if(j == 1)
+			value = sampleStats[i].min;
+			else if(j == 2)
+			value = sampleStats[i].max;
+			else
+			value = sampleStats[i].stddev;
+			
+			#if UDP_FORMAT == TELEMETRY_STATSD
+			strcpy_P(pos, PSTR(UDP_MEASUREMENT "."));
+			pos += strlen(pos);
+			pos = telemetryFormatName(i, (sampleStats != NULL) ? j : 4, pos);
+			*pos++ = ':';
+			pos = measureFormatValue(i, value, pos);
+			*pos++ = '|';
+			*pos++ = 'g';
+			*pos++ = '\n';
+			#else
+			if(first)
+			{
+				strcpy_P(pos, PSTR(UDP_MEASUREMENT " "));
+				pos += strlen(pos);
+			}
+			else
+			{
+				*pos++ = ',';
+			}
+			pos = telemetryFormatName(i, (sampleStats != NULL) ? j : 4, pos);
+			*pos++ = '=';
+			pos = measureFormatValue(i, value, pos);
+			#endif
+			
+			first = false;
+		}
+	}
+	
+	if(sampleAge != 0 && size - (uint16_t)(pos - data) >= TELEMETRY_ENTRY_MAX)
+	{
+		#if UDP_FORMAT == TELEMETRY_STATSD
+		strcpy_P(pos, PSTR(UDP_MEASUREMENT ".age:"));
+		pos += strlen(pos);
+		ultoa(sampleAge, pos, 10);
+		pos += strlen(pos);
+		*pos++ = '|';
+		*pos++ = 'g';
+		*pos++ = '\n';
+		#else
+		if(!first)
+		{
+			strcpy_P(pos, PSTR(",age="));
+			pos += strlen(pos);
+			ultoa(sampleAge, pos, 10);
+			pos += strlen(pos);
+			*pos++ = 'i';
+		}
+		#endif
+	}
+	
+	#if UDP_FORMAT != TELEMETRY_STATSD
+	if(!first)
+	*pos++ = '\n';
+	#endif
+	
+	return pos - data;
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file fatimage.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief FAT32 volume on the simulated SDcard (stub/sdimage.c)
+ *
+ * The image is written directly with the layout of the FAT32 specification (no MBR,
+ * boot sector at sector 0, FSInfo at sector 1, two FATs, root directory at cluster 2),
+ * so libs/sdcard/fat32.c reads it like a card formatted by a PC. The files of the
+ * tests are found and read back without the firmware code.
+*/
+
+#include "fatimage.h"
+#include "stub/sdimage.h"
+#include <string.h>
+
+#define RESERVED_SECTORS	32		/**< boot sector, FSInfo and backup		*/
+#define FAT_COPIES			2
+
+static uint8_t clusterSectors;		/**< sectors per cluster				*/
+static uint32_t fatSector;			/**< first sector of the first FAT		*/
+static uint32_t fatSectors;			/**< sectors per FAT					*/
+static uint32_t dataSector;			/**< first sector of cluster 2			*/
+static uint32_t totalClusters;		/**< clusters of the data area			*/
+
+/**
+*
+* @brief Store a little endian value
+*
+* @param data destination
+* @param value value
+* @param bytes size of the value
+*
+* @return void
+*/
+static void put(uint8_t *data, uint32_t value, uint8_t bytes)
+{
+	for(uint8_t i = 0; i < bytes; i++)
+	data[i] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+*
+* @brief Load a little endian value
+*
+* @param data source
+* @param bytes size of the value
+*
+* @return value
+*/
+static uint32_t get(const uint8_t *data, uint8_t bytes)
+{
+	uint32_t value = 0;
+	
+	for(uint8_t i = 0; i < bytes; i++)
+	value |= (uint32_t)data[i] << (8 * i);
+	
+	return value;
+}
+
+/**
+*
+* @brief Format the image
+*
+* @param sectors size of the volume
+* @param sectorsPerCluster sectors per cluster
+*
+* @return void
+*/
+void FatImage_Format(uint32_t sectors, uint8_t sectorsPerCluster)
+{
+	uint8_t data[512];
+	
+	clusterSectors = sectorsPerCluster;
+	
+	// the FATs have to cover all clusters of the remaining sectors
+	fatSectors = 1;
+	do{
+		fatSectors++;
+		totalClusters = (sectors - RESERVED_SECTORS - FAT_COPIES * fatSectors) / sectorsPerCluster;
+	}while((totalClusters + 2) * 4 > fatSectors * 512);
+	
+	fatSector = RESERVED_SECTORS;
+	dataSector = fatSector + FAT_COPIES * fatSectors;
+	
+	memset(data, 0, 512);
+	for(uint32_t s = 0; s < sectors; s++)
+	SDImage_Write(s, data);
+	
+	// boot sector
+	data[0] = 0xEB;
+	data[1] = 0x58;
+	data[2] = 0x90;
+	memcpy(&data[3], "MSWIN4.1", 8);
+	put(&data[11], 512, 2);
+	data[13] = sectorsPerCluster;
+	put(&data[14], RESERVED_SECTORS, 2);
+	data[16] = FAT_COPIES;
+	data[21] = 0xF8;
+	put(&data[32], sectors, 4);
+	put(&data[36], fatSectors, 4);
+	put(&data[44], 2, 4);
+	put(&data[48], 1, 2);
+	put(&data[50], 6, 2);
+	data[66] = 0x29;
+	memcpy(&data[82], "FAT32   ", 8);
+	put(&data[510], 0xAA55, 2);
+	SDImage_Write(0, data);
+	
+	// FSInfo
+	memset(data, 0, 512);
+	put(&data[0], 0x41615252, 4);
+	put(&data[484], 0x61417272, 4);
+	put(&data[488], totalClusters - 1, 4);
+	put(&data[492], 3, 4);
+	put(&data[508], 0xAA550000, 4);
+	SDImage_Write(1, data);
+	
+	// media descriptor, reserved entry and the root directory
+	FatImage_SetEntry(0, 0x0FFFFFF8);
+	FatImage_SetEntry(1, 0x0FFFFFFF);
+	FatImage_SetEntry(2, 0x0FFFFFFF);
+}
+
+/**
+*
+* @brief Add a contiguous file to the root directory
+*
+* The file takes the first free clusters which are large enough, the content is zero.
+*
+* @param fatName name in FAT format ("NAME    EXT")
+* @param size file size in bytes
+*
+* @return first cluster (0: empty file)
+*/
+uint32_t FatImage_AddFile(const char *fatName, uint32_t size)
+{
+	uint8_t data[512];
+	uint32_t clusterBytes = (uint32_t)clusterSectors * 512;
+	uint32_t clusters = (size + clusterBytes - 1) / clusterBytes;
+	uint32_t first = 0, free = 0;
+	
+	for(uint32_t cluster = 3; cluster < totalClusters + 2 && free < clusters; cluster++)
+	{
+		free = (FatImage_GetEntry(cluster) == 0) ? free + 1 : 0;
+		first = cluster + 1 - free;
+	}
+	
+	if(clusters == 0)
+	first = 0;
+	
+	for(uint32_t i = 0; i < clusters; i++)
+	FatImage_SetEntry(first + i, (i + 1 < clusters) ? first + i + 1 : 0x0FFFFFFF);
+	
+	// first free entry of the root directory
+	for(uint8_t s = 0; s < clusterSectors; s++)
+	{
+		SDImage_Read(dataSector + s, data);
+		
+		for(uint16_t i = 0; i < 512; i += 32)
+		{
+			if(data[i] != 0x00)
+			continue;
+			
+			memcpy(&data[i], fatName, 11);
+			data[i + 11] = 0x20;
+			put(&data[i + 20], first >> 16, 2);
+			put(&data[i + 26], first & 0xFFFF, 2);
+			put(&data[i + 28], size, 4);
+			SDImage_Write(dataSector + s, data);
+			
+			return first;
+		}
+	}
+	
+	return 0;
+}
+
+/**
+*
+* @brief Read an entry of the first FAT
+*
+* @param cluster cluster number
+*
+* @return entry (28 bit), 0xFFFFFFFF: the copies differ
+*/
+uint32_t FatImage_GetEntry(uint32_t cluster)
+{
+	uint8_t data[512];
+	uint32_t value = 0;
+	
+	for(uint8_t i = 0; i < FAT_COPIES; i++)
+	{
+		SDImage_Read(fatSector + i * fatSectors + cluster / 128, data);
+		
+		uint32_t entry = get(&data[(cluster % 128) * 4], 4) & 0x0FFFFFFF;
+		if(i > 0 && entry != value)
+		return 0xFFFFFFFF;
+		
+		value = entry;
+	}
+	
+	return value;
+}
+
+/**
+*
+* @brief Write an entry of every FAT
+*
+* @param cluster cluster number
+* @param value next cluster or end of chain
+*
+* @return void
+*/
+void FatImage_SetEntry(uint32_t cluster, uint32_t value)
+{
+	uint8_t data[512];
+	
+	for(uint8_t i = 0; i < FAT_COPIES; i++)
+	{
+		SDImage_Read(fatSector + i * fatSectors + cluster / 128, data);
+		put(&data[(cluster % 128) * 4], value, 4);
+		SDImage_Write(fatSector + i * fatSectors + cluster / 128, data);
+	}
+}
+
+/**
+*
+* @brief First sector of a cluster
+*
+* @param cluster cluster number
+*
+* @return sector on the image
+*/
+uint32_t FatImage_FirstSector(uint32_t cluster)
+{
+	return dataSector + (cluster - 2) * clusterSectors;
+}
+
+/**
+*
+* @brief Read a file of the root directory along its cluster chain
+*
+* @param fatName name in FAT format ("NAME    EXT")
+* @param data output of the content
+* @param max size of the output
+*
+* @return file size | FATIMAGE_NOT_FOUND: no such file, content too long, broken chain or
+* chain longer than the file
+*/
+uint32_t FatImage_ReadFile(const char *fatName, uint8_t *data, uint32_t max)
+{
+	uint8_t sector[512];
+	uint32_t cluster = 0, size = FATIMAGE_NOT_FOUND;
+	
+	for(uint8_t s = 0; s < clusterSectors && size == FATIMAGE_NOT_FOUND; s++)
+	{
+		SDImage_Read(dataSector + s, sector);
+		
+		for(uint16_t i = 0; i < 512; i += 32)
+		{
+			if(memcmp(&sector[i], fatName, 11) == 0)
+			{
+				cluster = get(&sector[i + 20], 2) << 16 | get(&sector[i + 26], 2);
+				size = get(&sector[i + 28], 4);
+				break;
+			}
+		}
+	}
+	
+	if(size == FATIMAGE_NOT_FOUND || size > max)
+	return FATIMAGE_NOT_FOUND;
+	
+	for(uint32_t pos = 0; pos < size; )
+	{
+		if(cluster < 2 || cluster >= totalClusters + 2)
+		return FATIMAGE_NOT_FOUND;
+		
+		for(uint8_t s = 0; s < clusterSectors && pos < size; s++)
+		{
+			uint32_t part = (size - pos > 512) ? 512 : size - pos;
+			
+			SDImage_Read(FatImage_FirstSector(cluster) + s, sector);
+			memcpy(&data[pos], sector, part);
+			pos += part;
+		}
+		
+		cluster = FatImage_GetEntry(cluster);
+	}
+	
+	// end of the chain after the last cluster (empty file: no cluster)
+	if(size > 0 && (cluster < 0x0FFFFFF8 || cluster > 0x0FFFFFFF))
+	return FATIMAGE_NOT_FOUND;
+	
+	return size;
+}
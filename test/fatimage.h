@@ -0,0 +1,47 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file fatimage.h
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+*/
+
+#ifndef FATIMAGE_H_
+#define FATIMAGE_H_
+
+#include <stdint.h>
+
+#define FATIMAGE_NOT_FOUND	0xFFFFFFFFUL	/**< FatImage_ReadFile(): no such file	*/
+
+void FatImage_Format(uint32_t sectors, uint8_t sectorsPerCluster);
+
+uint32_t FatImage_AddFile(const char *fatName, uint32_t size);
+
+uint32_t FatImage_GetEntry(uint32_t cluster);
+
+void FatImage_SetEntry(uint32_t cluster, uint32_t value);
+
+uint32_t FatImage_FirstSector(uint32_t cluster);
+
+uint32_t FatImage_ReadFile(const char *fatName, uint8_t *data, uint32_t max);
+
+#endif /* FATIMAGE_H_ */
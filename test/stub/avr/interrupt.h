@@ -0,0 +1,13 @@
+/**
+ * @file avr/interrupt.h
+ * @brief Host stub: an ISR is a function the test calls directly
+*/
+
+#ifndef STUB_AVR_INTERRUPT_H_
+#define STUB_AVR_INTERRUPT_H_
+
+#define ISR(vector)	void vector(void); void vector(void)
+#define sei()
+#define cli()
+
+#endif /* STUB_AVR_INTERRUPT_H_ */
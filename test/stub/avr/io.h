@@ -0,0 +1,35 @@
+/**
+ * @file avr/io.h
+ * @brief Host stub: the registers used by the tested modules are plain variables (avr_stub.c)
+*/
+
+#ifndef STUB_AVR_IO_H_
+#define STUB_AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t ADMUX, ADCSRA, ADCSRB;
+extern volatile uint16_t ADCW;
+extern volatile uint8_t TCNT0;
+extern volatile uint16_t TCNT1, OCR1B;
+extern volatile uint8_t TIMSK1, TIFR1;
+extern volatile uint8_t DDRB, PORTB;
+
+#define REFS1	7
+#define REFS0	6
+#define ADEN	7
+#define ADSC	6
+#define ADATE	5
+#define ADIE	3
+#define ADPS2	2
+#define ADPS1	1
+#define ADPS0	0
+#define OCIE1B	2
+#define OCF1B	2
+#define PINB1	1
+#define PINB3	3
+#define PINB4	4
+#define PINB5	5
+
+#endif /* STUB_AVR_IO_H_ */
@@ -0,0 +1,20 @@
+/**
+ * @file avr/pgmspace.h
+ * @brief Host stub: the flash is plain memory, the _P functions are the RAM functions
+*/
+
+#ifndef STUB_AVR_PGMSPACE_H_
+#define STUB_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)				(s)
+#define pgm_read_byte(a)	(*(const uint8_t *)(a))
+#define pgm_read_word(a)	(*(const uint16_t *)(a))
+#define memcpy_P			memcpy
+#define strcpy_P			strcpy
+#define strlen_P			strlen
+
+#endif /* STUB_AVR_PGMSPACE_H_ */
@@ -0,0 +1,14 @@
+/**
+ * @file avr_stub.c
+ * @brief Host stub: storage of the registers declared in avr/io.h
+*/
+
+#include <avr/io.h>
+
+volatile uint8_t SREG;
+volatile uint8_t ADMUX, ADCSRA, ADCSRB;
+volatile uint16_t ADCW;
+volatile uint8_t TCNT0;
+volatile uint16_t TCNT1, OCR1B;
+volatile uint8_t TIMSK1, TIFR1;
+volatile uint8_t DDRB, PORTB;
@@ -0,0 +1,450 @@
+/**
+ * @file sdimage.c
+ * @brief Host stub: SDcard in SPI mode on an image file
+ *
+ * SPI_transreceive() is the card side of the SPI bus, so libs/sdcard/sdcard.c runs
+ * unchanged against the image. Supported are the commands of SDInit() and the block
+ * commands CMD12, CMD17, CMD18, CMD24, CMD25 and ACMD23 (block addressing, SDHC).
+ *
+ * The busy time is a model (SDImageTiming): every programmed block keeps the data line
+ * low for timing.program bytes, a block which was not pre-erased for timing.erase bytes
+ * more. A single block write (CMD24) is never pre-erased. A multiple block write
+ * (CMD25) erases the range announced with ACMD23 with its first block. The busy time
+ * also runs out while the chip select is inactive.
+*/
+
+#include "sdimage.h"
+#include <avr/io.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SDIMAGE_CS			1		/**< chip select: PORTB bit (PINB1, ioconfig.h)	*/
+
+#define R1_IDLE				0x01
+#define R1_ILLEGAL			0x04
+#define R1_ADDRESS			0x40
+#define DATA_ACCEPTED		0xE5	/**< data response: accepted		*/
+#define DATA_WRITE_ERROR	0xED	/**< data response: write error		*/
+
+/**
+*
+* @brief State of the data line
+*
+*/
+typedef enum{
+	CARD_COMMAND,	/**< waiting for a command						*/
+	CARD_READ,		/**< CMD18: sending blocks until CMD12			*/
+	CARD_TOKEN,		/**< CMD24/CMD25: waiting for a start token		*/
+	CARD_DATA		/**< receiving a block and its CRC				*/
+}CardState;
+
+static FILE *image = NULL;								/**< image file					*/
+static uint32_t imageSectors = 0;						/**< size of the image			*/
+static SDImageTiming timing = { 64, 256, 32 };			/**< busy model					*/
+static SDImageStats stats;								/**< counters					*/
+
+static CardState state = CARD_COMMAND;
+static bool idle = true;								/**< in idle state (before ACMD41)	*/
+static bool app = false;								/**< last command was CMD55		*/
+static uint8_t command[6];								/**< received command			*/
+static uint8_t commandLength = 0;
+static uint32_t address = 0;							/**< next block of CMD18/CMD24/CMD25	*/
+static bool multi = false;								/**< CMD25 (true) or CMD24		*/
+static uint32_t eraseCount = 0;							/**< ACMD23 for the next CMD25	*/
+static uint32_t erased = 0;								/**< pre-erased blocks of CMD25	*/
+static uint32_t blockIndex = 0;							/**< block of the current CMD25	*/
+static uint32_t failSector = SDIMAGE_NO_FAIL;			/**< next rejected write		*/
+static uint8_t block[514];								/**< received block and CRC		*/
+static uint16_t blockLength = 0;
+static uint32_t busy = 0;								/**< busy bytes left			*/
+
+static uint8_t queue[520];								/**< bytes to send to the host	*/
+static uint16_t queueRead = 0, queueWrite = 0;
+
+/**
+*
+* @brief Append a byte to the output of the card
+*
+* @param data byte
+*
+* @return void
+*/
+static void queuePush(uint8_t data)
+{
+	if(queueRead == queueWrite)
+	queueRead = queueWrite = 0;
+	
+	queue[queueWrite++] = data;
+}
+
+/**
+*
+* @brief Append a block with gap, start token and CRC to the output
+*
+* @param sector sector of the image
+*
+* @return void
+*/
+static void queueBlock(uint32_t sector)
+{
+	uint8_t data[512];
+	
+	SDImage_Read(sector, data);
+	
+	queuePush(0xFF);
+	queuePush(0xFE);
+	for(uint16_t i = 0; i < 512; i++)
+	queuePush(data[i]);
+	queuePush(0xFF);
+	queuePush(0xFF);
+	
+	stats.blocksRead++;
+}
+
+/**
+*
+* @brief Execute a received command, the response follows after one byte
+*
+* @return void
+*/
+static void execute(void)
+{
+	uint8_t index = command[0] & 0x3F;
+	uint32_t arg = ((uint32_t)command[1] << 24) | ((uint32_t)command[2] << 16) | ((uint32_t)command[3] << 8) | command[4];
+	bool appCommand = app;
+	uint8_t r1 = idle ? R1_IDLE : 0x00;
+	
+	stats.commands++;
+	app = false;
+	
+	// a command ends the data stream of CMD18 (CMD12)
+	queueRead = queueWrite = 0;
+	queuePush(0xFF);
+	
+	if(index == 0)
+	{
+		idle = true;
+		state = CARD_COMMAND;
+		queuePush(R1_IDLE);
+	}
+	else if(index == 8)
+	{
+		queuePush(r1);
+		queuePush(0x00);
+		queuePush(0x00);
+		queuePush(0x01);
+		queuePush(command[4]);
+	}
+	else if(index == 55)
+	{
+		app = true;
+		queuePush(r1);
+	}
+	else if(index == 41 && appCommand)
+	{
+		idle = false;
+		queuePush(0x00);
+	}
+	else if(index == 58)
+	{
+		queuePush(r1);
+		queuePush(0xC0);
+		queuePush(0xFF);
+		queuePush(0x80);
+		queuePush(0x00);
+	}
+	else if(index == 23 && appCommand)
+	{
+		eraseCount = arg & 0x007FFFFF;
+		stats.eraseCounts++;
+		queuePush(r1);
+	}
+	else if(idle)
+	queuePush(R1_IDLE | R1_ILLEGAL);
+	else if(index == 12)
+	{
+		state = CARD_COMMAND;
+		queuePush(0xFF);
+		queuePush(0x00);
+	}
+	else if((index == 17 || index == 18 || index == 24 || index == 25) && arg >= imageSectors)
+	queuePush(R1_ADDRESS);
+	else if(index == 17)
+	{
+		queuePush(0x00);
+		queueBlock(arg);
+	}
+	else if(index == 18)
+	{
+		queuePush(0x00);
+		address = arg;
+		state = CARD_READ;
+	}
+	else if(index == 24 || index == 25)
+	{
+		queuePush(0x00);
+		address = arg;
+		multi = (index == 25);
+		erased = multi ? eraseCount : 0;
+		eraseCount = 0;
+		blockIndex = 0;
+		state = CARD_TOKEN;
+	}
+	else
+	queuePush(r1 | R1_ILLEGAL);
+}
+
+/**
+*
+* @brief Program a received block
+*
+* @return void
+*/
+static void program(void)
+{
+	if(address >= imageSectors || address == failSector)
+	{
+		failSector = SDIMAGE_NO_FAIL;
+		queuePush(DATA_WRITE_ERROR);
+	}
+	else
+	{
+		SDImage_Write(address, block);
+		stats.blocksWritten++;
+		queuePush(DATA_ACCEPTED);
+		
+		// the pre-erase of CMD25 is done with the first block
+		busy = timing.program;
+		if(!multi || blockIndex == 0 || blockIndex >= erased)
+		busy += timing.erase;
+	}
+	
+	address++;
+	blockIndex++;
+	state = multi ? CARD_TOKEN : CARD_COMMAND;
+}
+
+/**
+*
+* @brief Handle a byte from the host
+*
+* @param data received byte
+*
+* @return void
+*/
+static void receive(uint8_t data)
+{
+	if(state == CARD_DATA)
+	{
+		block[blockLength++] = data;
+		
+		if(blockLength == sizeof(block))
+		program();
+	}
+	else if(state == CARD_TOKEN)
+	{
+		if(data == (multi ? 0xFC : 0xFE))
+		{
+			blockLength = 0;
+			state = CARD_DATA;
+		}
+		else if(multi && data == 0xFD)
+		{
+			busy = timing.stop;
+			state = CARD_COMMAND;
+		}
+	}
+	else if(commandLength > 0 || (data & 0xC0) == 0x40)
+	{
+		command[commandLength++] = data;
+		
+		if(commandLength == sizeof(command))
+		{
+			commandLength = 0;
+			execute();
+		}
+	}
+}
+
+/**
+*
+* @brief Exchange a byte with the simulated SDcard
+*
+* @param databyte byte from the host
+*
+* @return byte from the SDcard (0xFF without chip select)
+*/
+uint8_t SPI_transreceive(uint8_t databyte)
+{
+	uint8_t out = 0xFF;
+	
+	stats.bytes++;
+	
+	if(PORTB & (1 << SDIMAGE_CS))
+	{
+		if(busy > 0)
+		{
+			busy--;
+			stats.busyBytes++;
+		}
+		
+		return 0xFF;
+	}
+	
+	if(queueRead != queueWrite)
+	out = queue[queueRead++];
+	else if(busy > 0)
+	{
+		busy--;
+		stats.busyBytes++;
+		return 0x00;
+	}
+	else if(state == CARD_READ)
+	{
+		queueBlock(address++);
+		out = queue[queueRead++];
+	}
+	
+	receive(databyte);
+	
+	return out;
+}
+
+void SPI_init()
+{
+}
+
+/**
+*
+* @brief Open or create an image
+*
+* A new image is filled with zeros, an existing image keeps its content.
+*
+* @param path image file (NULL: temporary file)
+* @param sectors size of the image in 512 byte sectors
+*
+* @return true: image ready | false: file error
+*/
+bool SDImage_Open(const char *path, uint32_t sectors)
+{
+	SDImage_Close();
+	
+	image = path ? fopen(path, "r+b") : NULL;
+	if(!image)
+	image = path ? fopen(path, "w+b") : tmpfile();
+	if(!image)
+	return false;
+	
+	imageSectors = sectors;
+	
+	// extend the file to the full size
+	fseek(image, 0, SEEK_END);
+	for(long size = ftell(image); size < (long)sectors * 512; size++)
+	fputc(0, image);
+	
+	state = CARD_COMMAND;
+	idle = true;
+	app = false;
+	commandLength = 0;
+	eraseCount = 0;
+	busy = 0;
+	failSector = SDIMAGE_NO_FAIL;
+	queueRead = queueWrite = 0;
+	SDImage_ResetStats();
+	
+	return true;
+}
+
+/**
+*
+* @brief Close the image file
+*
+* @return void
+*/
+void SDImage_Close(void)
+{
+	if(image)
+	fclose(image);
+	
+	image = NULL;
+}
+
+/**
+*
+* @brief Set the busy model
+*
+* @param newTiming busy time in SPI bytes
+*
+* @return void
+*/
+void SDImage_SetTiming(const SDImageTiming *newTiming)
+{
+	timing = *newTiming;
+}
+
+/**
+*
+* @brief Reject the next write of a sector with a write error
+*
+* @param sector sector (SDIMAGE_NO_FAIL: none)
+*
+* @return void
+*/
+void SDImage_FailWrite(uint32_t sector)
+{
+	failSector = sector;
+}
+
+/**
+*
+* @brief Read a sector of the image directly (without SPI)
+*
+* @param sector sector of the image
+* @param data output of 512 bytes
+*
+* @return void
+*/
+void SDImage_Read(uint32_t sector, uint8_t *data)
+{
+	memset(data, 0, 512);
+	fseek(image, (long)sector * 512, SEEK_SET);
+	if(fread(data, 1, 512, image) != 512)
+	memset(data, 0, 512);
+}
+
+/**
+*
+* @brief Write a sector of the image directly (without SPI)
+*
+* @param sector sector of the image
+* @param data 512 bytes
+*
+* @return void
+*/
+void SDImage_Write(uint32_t sector, const uint8_t *data)
+{
+	fseek(image, (long)sector * 512, SEEK_SET);
+	fwrite(data, 1, 512, image);
+}
+
+/**
+*
+* @brief Counters since SDImage_Open() or SDImage_ResetStats()
+*
+* @return counters
+*/
+const SDImageStats* SDImage_Stats(void)
+{
+	return &stats;
+}
+
+/**
+*
+* @brief Clear the counters
+*
+* @return void
+*/
+void SDImage_ResetStats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
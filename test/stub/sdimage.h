@@ -0,0 +1,55 @@
+/**
+ * @file sdimage.h
+ * @brief Host stub: SDcard in SPI mode on an image file, replaces libs/spi (sdimage.c)
+*/
+
+#ifndef STUB_SDIMAGE_H_
+#define STUB_SDIMAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SDIMAGE_NO_FAIL		0xFFFFFFFFUL	/**< SDImage_FailWrite(): no rejected write	*/
+
+/**
+*
+* @brief Busy time of the simulated SDcard in SPI bytes (data line low)
+*
+*/
+typedef struct{
+	uint16_t program;	/**< programming of a block							*/
+	uint16_t erase;		/**< additional erase of a block not pre-erased		*/
+	uint16_t stop;		/**< stop token of a multiple block write			*/
+}SDImageTiming;
+
+/**
+*
+* @brief Counters of the simulated SDcard
+*
+*/
+typedef struct{
+	uint32_t commands;		/**< commands received								*/
+	uint32_t eraseCounts;	/**< ACMD23 received								*/
+	uint32_t blocksRead;	/**< blocks sent to the host						*/
+	uint32_t blocksWritten;	/**< blocks programmed								*/
+	uint64_t bytes;			/**< bytes clocked over SPI (also without chip select)	*/
+	uint64_t busyBytes;		/**< bytes clocked while the SDcard was busy		*/
+}SDImageStats;
+
+bool SDImage_Open(const char *path, uint32_t sectors);
+
+void SDImage_Close(void);
+
+void SDImage_SetTiming(const SDImageTiming *timing);
+
+void SDImage_FailWrite(uint32_t sector);
+
+void SDImage_Read(uint32_t sector, uint8_t *data);
+
+void SDImage_Write(uint32_t sector, const uint8_t *data);
+
+const SDImageStats* SDImage_Stats(void);
+
+void SDImage_ResetStats(void);
+
+#endif /* STUB_SDIMAGE_H_ */
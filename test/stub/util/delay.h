@@ -0,0 +1,12 @@
+/**
+ * @file util/delay.h
+ * @brief Host stub: the delays return at once
+*/
+
+#ifndef STUB_UTIL_DELAY_H_
+#define STUB_UTIL_DELAY_H_
+
+#define _delay_ms(ms)	((void)(ms))
+#define _delay_us(us)	((void)(us))
+
+#endif /* STUB_UTIL_DELAY_H_ */
@@ -0,0 +1,29 @@
+/**
+ * @file test.h
+ * @brief Minimal check macros of the host tests
+ *
+ * A failed check prints its position and ends the test with exit code 1.
+*/
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(condition) do{ \
+	if(!(condition)){ \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+		exit(1); \
+	} \
+}while(0)
+
+#define CHECK_EQ(actual, expected) do{ \
+	long long _a = (long long)(actual), _e = (long long)(expected); \
+	if(_a != _e){ \
+		printf("%s:%d: %s = %lld, expected %lld\n", __FILE__, __LINE__, #actual, _a, _e); \
+		exit(1); \
+	} \
+}while(0)
+
+#endif /* TEST_H_ */
@@ -0,0 +1,278 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_adc.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the ADC scan sequencer and the frame ring buffer
+ *
+ * Synthetic conversions are fed through the ADC complete interrupt (ADC_vect), the
+ * frames are taken out with ADC_PopFrame() like the main loop does.
+*/
+
+#include "test.h"
+#include "../libs/adc/adc.h"
+#include "../libs/timebase/timebase.h"
+
+static uint32_t ticks = 0;	/**< simulated timebase */
+
+void ADC_vect(void);		/**< interrupt vector, a plain function with the stub ISR() */
+
+void Timebase_Init(void)
+{
+}
+
+uint32_t Timebase_Ticks(void)
+{
+	return ticks;
+}
+
+uint32_t Timebase_Extend(uint32_t now, uint16_t stamp)
+{
+	(void)stamp;
+	return now;
+}
+
+/**
+*
+* @brief Feed one conversion result through the interrupt
+*
+* @param value ADC result
+*
+* @return void
+*/
+static void convert(uint16_t value)
+{
+	ADCW = value;
+	ADC_vect();
+}
+
+/**
+*
+* @brief Feed one complete scan, every conversion of channel i has the value base + i
+*
+* @param channels scan list
+* @param count count of channels
+* @param base value of the first channel
+*
+* @return void
+*/
+static void scan(const ADC_ScanChannel *channels, uint8_t count, uint16_t base)
+{
+	for(uint8_t i = 0; i < count; i++)
+	{
+		uint16_t conversions = channels[i].discard + (1 << (2 * channels[i].extraBits));
+		
+		for(uint16_t k = 0; k < conversions; k++)
+		convert(base + i);
+	}
+	
+	ticks += 92;
+}
+
+/**
+*
+* @brief A full ring buffer drops the new frames and counts them
+*
+* @return void
+*/
+static void testOverflow(void)
+{
+	static const ADC_ScanChannel channels[] = { {0, ADC_REF_AVCC, 0, 0}, {1, ADC_REF_AVCC, 0, 0} };
+	ADC_Frame frame;
+	
+	ADC_ScanConfigure(channels, 2);
+	ADC_StartTriggered(ADC_TRIGGER_TIMER1, 92);
+	ticks = 1000;
+	
+	CHECK_EQ(ADC_Available(), 0);
+	CHECK(!ADC_PopFrame(&frame));
+	
+	// no consumer: one slot stays empty, all further frames are dropped
+	for(uint16_t n = 0; n < 20; n++)
+	scan(channels, 2, 10 * n);
+	
+	CHECK_EQ(ADC_Available(), ADC_BUFFER_SIZE - 1);
+	CHECK_EQ(ADC_GetDroppedFrames(), 20 - (ADC_BUFFER_SIZE - 1));
+	
+	// the oldest frames are kept
+	for(uint8_t n = 0; n < ADC_BUFFER_SIZE - 1; n++)
+	{
+		CHECK(ADC_PopFrame(&frame));
+		CHECK_EQ(frame.sequence, n);
+		CHECK_EQ(frame.value[0], 10 * n);
+		CHECK_EQ(frame.value[1], 10 * n + 1);
+		CHECK_EQ(frame.timestamp, 1000 + 92 * n);
+	}
+	CHECK(!ADC_PopFrame(&frame));
+	
+	// the gap of the sequence counter equals the dropped frames
+	scan(channels, 2, 500);
+	CHECK(ADC_PopFrame(&frame));
+	CHECK_EQ(frame.sequence, 20);
+	CHECK_EQ(frame.value[0], 500);
+	CHECK_EQ(ADC_GetDroppedFrames(), 13);
+}
+
+/**
+*
+* @brief A consumer which drains at least every ADC_BUFFER_SIZE - 1 frames loses nothing
+*
+* @return void
+*/
+static void testMaxRate(void)
+{
+	static const ADC_ScanChannel channels[] = { {0, ADC_REF_AVCC, 0, 1}, {1, ADC_REF_AVCC, 0, 1}, {2, ADC_REF_AVCC, 0, 1}, {3, ADC_REF_AVCC, 0, 1} };
+	ADC_Frame frame;
+	uint8_t sequence = 0;
+	uint32_t frames = 0;
+	
+	ADC_ScanConfigure(channels, 4);
+	ADC_StartTriggered(ADC_TRIGGER_TIMER1, 92);
+	
+	for(uint16_t n = 0; n < 10000; n++)
+	{
+		scan(channels, 4, n & 0x3FF);
+		
+		if(n % (ADC_BUFFER_SIZE - 1) != ADC_BUFFER_SIZE - 2)
+		continue;
+		
+		while(ADC_PopFrame(&frame))
+		{
+			CHECK_EQ(frame.sequence, sequence);
+			CHECK_EQ(frame.value[3], (frames & 0x3FF) + 3);
+			sequence++;
+			frames++;
+		}
+	}
+	
+	CHECK_EQ(ADC_GetDroppedFrames(), 0);
+	CHECK_EQ(frames + ADC_Available(), 10000);
+}
+
+/**
+*
+* @brief Discarded conversions after a channel switch are not part of the value
+*
+* @return void
+*/
+static void testDiscard(void)
+{
+	static const ADC_ScanChannel channels[] = { {0, ADC_REF_AVCC, 0, 2}, {1, ADC_REF_AVCC, 0, 1} };
+	ADC_Frame frame;
+	
+	ADC_ScanConfigure(channels, 2);
+	ADC_StartTriggered(ADC_TRIGGER_TIMER1, 92);
+	
+	convert(1023);
+	convert(1023);
+	convert(100);
+	convert(1023);
+	convert(200);
+	
+	CHECK(ADC_PopFrame(&frame));
+	CHECK_EQ(frame.value[0], 100);
+	CHECK_EQ(frame.value[1], 200);
+}
+
+/**
+*
+* @brief Free running mode publishes every ADC_FREERUN_DIVIDER-th scan
+*
+* @return void
+*/
+static void testFreeRunning(void)
+{
+	static const ADC_ScanChannel channels[] = { {0, ADC_REF_AVCC, 0, 0} };
+	ADC_Frame frame;
+	
+	ADC_ScanConfigure(channels, 1);
+	ADC_StartFreeRunning();
+	
+	for(uint16_t n = 0; n < 5 * ADC_FREERUN_DIVIDER; n++)
+	scan(channels, 1, n);
+	
+	CHECK_EQ(ADC_Available(), 5);
+	
+	for(uint8_t n = 0; n < 5; n++)
+	{
+		CHECK(ADC_PopFrame(&frame));
+		CHECK_EQ(frame.sequence, n);
+		CHECK_EQ(frame.value[0], (n + 1) * ADC_FREERUN_DIVIDER - 1);
+	}
+}
+
+/**
+*
+* @brief Oversampling sums 4^n conversions and decimates them to 10+n bits
+*
+* @return void
+*/
+static void testOversampling(void)
+{
+	static const ADC_ScanChannel channels[] = { {0, ADC_REF_AVCC, 2, 0}, {1, ADC_REF_AVCC, 1, 0}, {2, ADC_REF_AVCC, 7, 0} };
+	ADC_Frame frame;
+	
+	// extraBits above ADC_MAX_EXTRA_BITS are limited
+	ADC_ScanConfigure(channels, 3);
+	ADC_StartTriggered(ADC_TRIGGER_TIMER1, 92);
+	
+	// 511.5 on average -> 2046 with 2 extra bits
+	for(uint8_t k = 0; k < 16; k++)
+	convert(511 + (k & 1));
+	
+	// 0, 1, 2, 3 -> 1.5 -> 3 with 1 extra bit
+	for(uint8_t k = 0; k < 4; k++)
+	convert(k);
+	
+	// full scale with 6 extra bits: 1023 << 6, the 16 bit result does not overflow
+	for(uint16_t k = 0; k < 4096; k++)
+	convert(1023);
+	
+	CHECK(ADC_PopFrame(&frame));
+	CHECK_EQ(frame.value[0], 2046);
+	CHECK_EQ(frame.value[1], 3);
+	CHECK_EQ(frame.value[2], 1023 << 6);
+	
+	// the sum starts again with the next scan: zero input
+	for(uint16_t k = 0; k < 16 + 4 + 4096; k++)
+	convert(0);
+	
+	CHECK(ADC_PopFrame(&frame));
+	CHECK_EQ(frame.value[0], 0);
+	CHECK_EQ(frame.value[1], 0);
+	CHECK_EQ(frame.value[2], 0);
+	CHECK(!ADC_PopFrame(&frame));
+}
+
+int main(void)
+{
+	testOverflow();
+	testMaxRate();
+	testDiscard();
+	testFreeRunning();
+	testOversampling();
+	
+	puts("ok");
+	return 0;
+}
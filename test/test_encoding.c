@@ -0,0 +1,319 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_encoding.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the delta/varint sample encoding
+ *
+ * The compression ratio is measured on a trace in the format of the SD log (LOG_FILE,
+ * first channel). data/trace.csv is a generated stand-in with the noise and drift of
+ * a slow sensor at 100ms, not a recording; a log of the SDcard can be measured with
+ * "build/test_encoding LOG.CSV".
+*/
+
+#include "test.h"
+#include "../libs/encoding/encoding.h"
+#include "../routines/batchRoutine.h"
+#include <stdio.h>
+#include <time.h>
+
+#define TRACE_FILE			"data/trace.csv"	/**< default trace						*/
+#define TRACE_MAX			2000				/**< max. samples read from a trace		*/
+#define TRACE_EXTRA_BITS	2					/**< oversampling of the logged channel	*/
+#define RAW_SAMPLE_SIZE		6					/**< 4 byte time + 2 byte value			*/
+
+/**
+*
+* @brief Encode samples, decode them and compare
+*
+* @param times timestamps (not decreasing)
+* @param values sample values
+* @param count count of samples
+*
+* @return size of the encoded block
+*/
+static uint16_t roundTrip(const uint32_t *times, const uint16_t *values, uint16_t count)
+{
+	static uint8_t buffer[ENCODE_MAX_SAMPLE_SIZE * TRACE_MAX];
+	EncodeBlock encoder;
+	DecodeBlock decoder;
+	uint32_t time;
+	uint16_t value;
+	
+	Encode_Begin(&encoder, buffer, sizeof(buffer));
+	for(uint16_t i = 0; i < count; i++)
+	CHECK(Encode_Add(&encoder, times[i], values[i]));
+	
+	CHECK_EQ(encoder.count, count);
+	
+	Decode_Begin(&decoder, buffer, encoder.length);
+	for(uint16_t i = 0; i < count; i++)
+	{
+		CHECK(Decode_Next(&decoder, &time, &value));
+		CHECK_EQ(time, times[i]);
+		CHECK_EQ(value, values[i]);
+	}
+	CHECK(!Decode_Next(&decoder, &time, &value));
+	
+	return encoder.length;
+}
+
+/**
+*
+* @brief Extremes: 0/0xFFFF values, full scale jumps in both directions, max. timestamp
+*
+* @return void
+*/
+static void testExtremes(void)
+{
+	static const uint32_t times[] = {0, 0, 1, 127, 128, 16511, 0xFFFFFFF0, 0xFFFFFFFF};
+	static const uint16_t values[] = {0, 0xFFFF, 0, 0xFFFF, 0x7FFF, 0x8000, 1, 0xFFFF};
+	
+	roundTrip(times, values, sizeof(times) / sizeof(times[0]));
+	
+	// max. sample sizes: 5 + 3 byte base, 3 byte value delta of +-65535
+	static const uint32_t baseTime[] = {0xFFFFFFFF};
+	static const uint16_t baseValue[] = {0xFFFF};
+	CHECK_EQ(roundTrip(baseTime, baseValue, 1), ENCODE_MAX_SAMPLE_SIZE);
+	
+	static const uint32_t jumpTimes[] = {0, 0, 0};
+	static const uint16_t jumpValues[] = {0, 0xFFFF, 0};
+	CHECK_EQ(roundTrip(jumpTimes, jumpValues, 3), 2 + 4 + 4);
+}
+
+/**
+*
+* @brief Zig-zag mapping: 0, -1, 1, -2, 2 -> 0, 1, 2, 3, 4 (one byte per field)
+*
+* @return void
+*/
+static void testZigZag(void)
+{
+	static const uint16_t values[] = {1000, 1000, 999, 1000, 998, 1000, 936, 1000};
+	static const uint8_t deltas[] = {0, 1, 2, 3, 4, 127, 128};
+	uint8_t buffer[32];
+	EncodeBlock encoder;
+	
+	Encode_Begin(&encoder, buffer, sizeof(buffer));
+	for(uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+	CHECK(Encode_Add(&encoder, 10 * i, values[i]));
+	
+	// base: 0 and 1000 (2 byte varint), then pairs of time and value delta
+	CHECK_EQ(buffer[0], 0);
+	CHECK_EQ(buffer[1], 0xE8);
+	CHECK_EQ(buffer[2], 0x07);
+	
+	for(uint8_t i = 0; i < 6; i++)
+	{
+		CHECK_EQ(buffer[3 + 2 * i], 10);
+		CHECK_EQ(buffer[4 + 2 * i], deltas[i]);
+	}
+	
+	// -64 -> 127 still one byte, +64 -> 128 needs two
+	CHECK_EQ(buffer[15], 10);
+	CHECK_EQ(buffer[16], 0x80);
+	CHECK_EQ(buffer[17], 0x01);
+	CHECK_EQ(encoder.length, 18);
+}
+
+/**
+*
+* @brief Rejected samples leave the block unchanged
+*
+* @return void
+*/
+static void testLimits(void)
+{
+	uint8_t buffer[6];
+	EncodeBlock encoder;
+	DecodeBlock decoder;
+	uint32_t time;
+	uint16_t value;
+	
+	Encode_Begin(&encoder, buffer, sizeof(buffer));
+	CHECK(Encode_Add(&encoder, 100, 500));
+	
+	// timestamp out of order
+	CHECK(!Encode_Add(&encoder, 99, 500));
+	
+	// buffer full: no partial sample
+	CHECK(Encode_Add(&encoder, 101, 501));
+	CHECK_EQ(encoder.length, 5);
+	CHECK(!Encode_Add(&encoder, 102, 0xFFFF));
+	CHECK_EQ(encoder.length, 5);
+	CHECK_EQ(encoder.count, 2);
+	
+	// truncated block: the incomplete sample is not decoded
+	Decode_Begin(&decoder, buffer, 4);
+	CHECK(Decode_Next(&decoder, &time, &value));
+	CHECK(!Decode_Next(&decoder, &time, &value));
+	
+	// varint longer than 5 byte is invalid
+	static const uint8_t invalid[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x00};
+	Decode_Begin(&decoder, invalid, sizeof(invalid));
+	CHECK(!Decode_Next(&decoder, &time, &value));
+}
+
+/**
+*
+* @brief Random walks and random full scale values
+*
+* @return void
+*/
+static void testRandom(void)
+{
+	static uint32_t times[1000];
+	static uint16_t values[1000];
+	uint32_t seed = 12345;
+	
+	for(uint8_t run = 0; run < 100; run++)
+	{
+		uint32_t time = seed;
+		uint16_t value = (uint16_t)(seed >> 8);
+		
+		for(uint16_t i = 0; i < 1000; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			
+			time += (run & 1) ? (seed >> 28) : 15;
+			
+			if(run % 3 == 0)
+			value = (uint16_t)(seed >> 12);
+			else
+			value += (int8_t)(seed >> 20) / 4;
+			
+			times[i] = time;
+			values[i] = value;
+		}
+		
+		uint16_t length = roundTrip(times, values, 1000);
+		
+		// small steps: 2 byte per sample
+		if(run % 3 != 0 && (run & 1) == 0)
+		CHECK(length <= 8 + 999 * 2);
+	}
+}
+
+/**
+*
+* @brief Read the first channel of a log file
+*
+* @param path CSV file ("ms,value,..." after a header line)
+* @param times output of the timestamps
+* @param values output of the values (10 + TRACE_EXTRA_BITS bits)
+*
+* @return count of samples
+*/
+static uint16_t loadTrace(const char *path, uint32_t *times, uint16_t *values)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+	unsigned long time;
+	double value;
+	uint16_t count = 0;
+	
+	CHECK(file != NULL);
+	
+	while(count < TRACE_MAX && fgets(line, sizeof(line), file))
+	{
+		if(sscanf(line, "%lu,%lf", &time, &value) != 2)
+		continue;
+		
+		times[count] = time;
+		values[count] = (uint16_t)(value * (1 << TRACE_EXTRA_BITS) + 0.5);
+		count++;
+	}
+	
+	fclose(file);
+	
+	return count;
+}
+
+/**
+*
+* @brief Compression ratio and encode time of a trace
+*
+* The trace is encoded as one block and in blocks of BATCH_SIZE samples (the batch of
+* an upload, every block starts with a base sample).
+*
+* @param path trace file
+* @param check true: check the ratio of the default trace
+*
+* @return void
+*/
+static void testTrace(const char *path, bool check)
+{
+	static uint32_t times[TRACE_MAX];
+	static uint16_t values[TRACE_MAX];
+	static uint8_t buffer[ENCODE_MAX_SAMPLE_SIZE * BATCH_SIZE];
+	EncodeBlock encoder;
+	uint32_t batched = 0;
+	
+	uint16_t count = loadTrace(path, times, values);
+	CHECK(count > BATCH_SIZE);
+	
+	uint16_t length = roundTrip(times, values, count);
+	
+	for(uint16_t i = 0; i < count; i += BATCH_SIZE)
+	{
+		uint16_t n = (count - i < BATCH_SIZE) ? count - i : BATCH_SIZE;
+		
+		batched += roundTrip(&times[i], &values[i], n);
+	}
+	
+	// encode time on the build machine
+	clock_t start = clock();
+	for(uint16_t run = 0; run < 1000; run++)
+	{
+		Encode_Begin(&encoder, buffer, sizeof(buffer));
+		for(uint16_t i = 0; i < BATCH_SIZE; i++)
+		Encode_Add(&encoder, times[i], values[i]);
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	
+	printf("  %s: %u samples, block %.2f byte/sample (ratio %.2f), batches of %u %.2f byte/sample (ratio %.2f), %.0f ns/sample on the host\n",
+		path, count, (double)length / count, (double)RAW_SAMPLE_SIZE * count / length,
+		BATCH_SIZE, (double)batched / count, (double)RAW_SAMPLE_SIZE * count / batched,
+		seconds * 1e9 / (1000.0 * BATCH_SIZE));
+	
+	// 100ms steps and noise of a few counts take 1 byte time and 1 byte value delta,
+	// the spikes 2 byte
+	if(check)
+	{
+		CHECK(RAW_SAMPLE_SIZE * count >= 2.9 * length);
+		CHECK(RAW_SAMPLE_SIZE * count >= 2.75 * batched);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	testExtremes();
+	testZigZag();
+	testLimits();
+	testRandom();
+	testTrace((argc > 1) ? argv[1] : TRACE_FILE, argc <= 1);
+	
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,268 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_fat32.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the FAT32 append writer
+ *
+ * The log file is written with appendFile() to a FAT32 image of the simulated SDcard
+ * and read back along its cluster chain by fatimage.c.
+*/
+
+#include "test.h"
+#include "fatimage.h"
+#include "stub/sdimage.h"
+#include "../libs/sdcard/sdcard.h"
+#include <stdio.h>
+#include <string.h>
+
+#define IMAGE_SECTORS	8192		/**< 4MB image						*/
+#define CLUSTER_SECTORS	4			/**< 2kB clusters					*/
+#define LOG_NAME		"LOG     CSV"
+
+static char expected[16384];		/**< content written so far			*/
+static uint32_t expectedSize;
+static uint8_t content[16384];		/**< content read back				*/
+
+/**
+*
+* @brief Format the image with a config file and open the log file
+*
+* @return void
+*/
+static void setup(void)
+{
+	char fileName[12] = "log.csv";
+	
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	FatImage_Format(IMAGE_SECTORS, CLUSTER_SECTORS);
+	FatImage_AddFile("CONFIG  TXT", 100);
+	
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	CHECK_EQ(getBootSectorData(), 0);
+	CHECK_EQ(openAppendFile(fileName), 0);
+	
+	expectedSize = 0;
+}
+
+/**
+*
+* @brief Append data to the log file and to the expected content
+*
+* @param data data
+* @param length count of bytes
+*
+* @return void
+*/
+static void append(const char *data, uint16_t length)
+{
+	CHECK_EQ(appendFile(data, length), 0);
+	
+	memcpy(&expected[expectedSize], data, length);
+	expectedSize += length;
+}
+
+/**
+*
+* @brief Compare the log file on the image with the expected content
+*
+* @return void
+*/
+static void checkFile(void)
+{
+	CHECK_EQ(FatImage_ReadFile(LOG_NAME, content, sizeof(content)), expectedSize);
+	CHECK(memcmp(content, expected, expectedSize) == 0);
+	
+	// the other file is unchanged
+	CHECK_EQ(FatImage_ReadFile("CONFIG  TXT", content, sizeof(content)), 100);
+}
+
+/**
+*
+* @brief Lines, blocks of lines and blocks larger than a cluster
+*
+* @return void
+*/
+static void testAppend(void)
+{
+	char line[40], block[3000];
+	uint16_t blockLength = 0;
+	uint8_t fsInfo[512];
+	
+	setup();
+	CHECK_EQ(_fileSize, 0);
+	
+	for(uint16_t i = 0; i < 300; i++)
+	{
+		uint16_t length = sprintf(line, "%u,%u.%03u\r\n", i * 1000, i, i % 1000);
+		
+		if(i % 50 < 20)
+		append(line, length);
+		else
+		{
+			memcpy(&block[blockLength], line, length);
+			blockLength += length;
+			
+			if(i % 50 == 49)
+			{
+				append(block, blockLength);
+				blockLength = 0;
+			}
+		}
+	}
+	
+	memset(block, 'x', sizeof(block));
+	append(block, sizeof(block));
+	
+	CHECK_EQ(syncAppendFile(), 0);
+	checkFile();
+	
+	// the sectors of a cluster were written with CMD25
+	CHECK(SDImage_Stats()->eraseCounts > 0);
+	
+	// the free cluster count is invalid after the allocation
+	SDImage_Read(1, fsInfo);
+	CHECK_EQ(fsInfo[488] & fsInfo[489] & fsInfo[490] & fsInfo[491], 0xFF);
+	
+	// the directory entry is only updated by syncAppendFile()
+	append("tail\r\n", 6);
+	CHECK_EQ(FatImage_ReadFile(LOG_NAME, content, sizeof(content)), expectedSize - 6);
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+	CHECK(appendFile("x", 1) != 0);
+}
+
+/**
+*
+* @brief Reopen the file and continue in the started sector
+*
+* @return void
+*/
+static void testReopen(void)
+{
+	char fileName[12] = "log.csv";
+	
+	setup();
+	append("first line\r\n", 12);
+	CHECK_EQ(closeAppendFile(), 0);
+	
+	CHECK_EQ(openAppendFile(fileName), 0);
+	CHECK_EQ(_fileSize, 12);
+	append("second line\r\n", 13);
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+	
+	// a file ending at a cluster border
+	strcpy(fileName, "log.csv");
+	CHECK_EQ(openAppendFile(fileName), 0);
+	memset(content, 'y', sizeof(content));
+	append((char *)content, CLUSTER_SECTORS * 512 - expectedSize);
+	CHECK_EQ(closeAppendFile(), 0);
+	
+	strcpy(fileName, "log.csv");
+	CHECK_EQ(openAppendFile(fileName), 0);
+	CHECK_EQ(_fileSize, CLUSTER_SECTORS * 512);
+	append("next cluster\r\n", 14);
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+}
+
+/**
+*
+* @brief The chain skips clusters of another file
+*
+* @return void
+*/
+static void testFragmented(void)
+{
+	uint8_t fill[3000];
+	
+	setup();
+	append("first cluster\r\n", 15);
+	CHECK_EQ(syncAppendFile(), 0);
+	
+	// the following clusters belong to another file
+	uint32_t other = FatImage_AddFile("OTHER   TXT", 2 * CLUSTER_SECTORS * 512);
+	CHECK_EQ(other, _appendStartCluster + 1);
+	
+	memset(fill, 'z', sizeof(fill));
+	append((char *)fill, sizeof(fill));
+	append((char *)fill, sizeof(fill));
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+	
+	CHECK(FatImage_GetEntry(_appendStartCluster) >= other + 2);
+	CHECK_EQ(FatImage_ReadFile("OTHER   TXT", content, sizeof(content)), 2 * CLUSTER_SECTORS * 512);
+}
+
+/**
+*
+* @brief A failed write after a cluster allocation, the retry uses the new cluster
+*
+* @return void
+*/
+static void testWriteError(void)
+{
+	uint8_t fill[3000];
+	
+	setup();
+	memset(fill, 'a', sizeof(fill));
+	append((char *)fill, CLUSTER_SECTORS * 512);
+	uint32_t next = _appendStartCluster + 1;
+	
+	// single sector write
+	SDImage_FailWrite(FatImage_FirstSector(next));
+	CHECK(appendFile("lost\r\n", 6) != 0);
+	CHECK_EQ(_fileSize, CLUSTER_SECTORS * 512);
+	append("retry\r\n", 7);
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+	CHECK_EQ(FatImage_GetEntry(_appendStartCluster), next);
+	
+	// block in a multiple block write
+	char fileName[12] = "log.csv";
+	CHECK_EQ(openAppendFile(fileName), 0);
+	memset(fill, 'b', sizeof(fill));
+	append((char *)fill, 2 * CLUSTER_SECTORS * 512 - expectedSize);
+	
+	SDImage_FailWrite(FatImage_FirstSector(next + 1) + 1);
+	CHECK(appendFile((char *)fill, sizeof(fill)) != 0);
+	append((char *)fill, sizeof(fill));
+	CHECK_EQ(closeAppendFile(), 0);
+	checkFile();
+	CHECK_EQ(FatImage_GetEntry(next), next + 1);
+}
+
+int main(void)
+{
+	testAppend();
+	testReopen();
+	testFragmented();
+	testWriteError();
+	
+	SDImage_Close();
+	
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,283 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_filter.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the filter chain
+ *
+ * The benchmark runs every filter type over the values of data/trace.csv (see
+ * test_encoding.c). The host time only compares the filter types, the cycles on the
+ * target are measured with measureFilterTicks() (DEBUG_MODE).
+*/
+
+#include "test.h"
+#include "../libs/filter/filter.h"
+#include <stdio.h>
+#include <time.h>
+
+#define TRACE_FILE			"data/trace.csv"	/**< trace of the benchmark				*/
+#define TRACE_MAX			2000				/**< max. samples read from the trace	*/
+#define BENCH_RUNS			1000				/**< passes over the trace				*/
+
+/**
+*
+* @brief Initialize a chain with one stage
+*
+* @param chain filter chain
+* @param type filter type
+* @param param filter parameter
+*
+* @return void
+*/
+static void initStage(FilterChain *chain, uint8_t type, uint8_t param)
+{
+	const FilterConfig config[FILTER_MAX_STAGES] = { {type, param}, {FILTER_NONE, 0}, {FILTER_NONE, 0} };
+	
+	Filter_Init(chain, config);
+}
+
+/**
+*
+* @brief Moving average over 2^n values
+*
+* @return void
+*/
+static void testMovingAverage(void)
+{
+	static const uint16_t expected[] = {250, 500, 750, 1000, 1000};
+	FilterChain chain;
+	
+	initStage(&chain, FILTER_MOVING_AVERAGE, 2);
+	
+	// the first value fills the window
+	CHECK_EQ(Filter_Process(&chain, 0), 0);
+	
+	for(uint8_t i = 0; i < 5; i++)
+	CHECK_EQ(Filter_Process(&chain, 1000), expected[i]);
+	
+	// full scale 16 bit values with the largest window
+	initStage(&chain, FILTER_MOVING_AVERAGE, 9);
+	CHECK_EQ(chain.stage[0].param, 3);
+	
+	for(uint8_t i = 0; i < 20; i++)
+	CHECK_EQ(Filter_Process(&chain, 0xFFFF), 0xFFFF);
+	
+	for(uint8_t i = 0; i < 8; i++)
+	Filter_Process(&chain, 0);
+	
+	CHECK_EQ(Filter_Process(&chain, 0), 0);
+}
+
+/**
+*
+* @brief Single-pole IIR lowpass with 8 fractional bits
+*
+* @return void
+*/
+static void testIIR(void)
+{
+	FilterChain chain;
+	uint16_t value = 0;
+	
+	initStage(&chain, FILTER_IIR, 2);
+	
+	// y += (x - y) / 4: 256, 448, 592...
+	CHECK_EQ(Filter_Process(&chain, 0), 0);
+	CHECK_EQ(Filter_Process(&chain, 1024), 256);
+	CHECK_EQ(Filter_Process(&chain, 1024), 448);
+	CHECK_EQ(Filter_Process(&chain, 1024), 592);
+	
+	for(uint8_t i = 0; i < 100; i++)
+	value = Filter_Process(&chain, 1024);
+	CHECK_EQ(value, 1024);
+	
+	// rising to full scale never wraps around, falling reaches 0
+	initStage(&chain, FILTER_IIR, 15);
+	Filter_Process(&chain, 0);
+	for(uint32_t i = 0; i < 1000000; i++)
+	{
+		uint16_t next = Filter_Process(&chain, 0xFFFF);
+		CHECK(next >= value || i == 0);
+		value = next;
+	}
+	CHECK(value > 0xFF00);
+	
+	initStage(&chain, FILTER_IIR, 4);
+	Filter_Process(&chain, 0xFFFF);
+	for(uint16_t i = 0; i < 1000; i++)
+	value = Filter_Process(&chain, 0);
+	CHECK_EQ(value, 0);
+}
+
+/**
+*
+* @brief Median of 3 or 5 values removes spikes
+*
+* @return void
+*/
+static void testMedian(void)
+{
+	static const uint16_t input3[] = {100, 100, 0xFFFF, 100, 0, 100, 101, 102};
+	static const uint16_t output3[] = {100, 100, 100, 100, 100, 100, 100, 101};
+	static const uint16_t input5[] = {500, 0xFFFF, 0xFFFF, 500, 0, 0, 500, 500};
+	FilterChain chain;
+	
+	initStage(&chain, FILTER_MEDIAN, 3);
+	for(uint8_t i = 0; i < sizeof(input3) / sizeof(input3[0]); i++)
+	CHECK_EQ(Filter_Process(&chain, input3[i]), output3[i]);
+	
+	// two following spikes need a window of 5
+	initStage(&chain, FILTER_MEDIAN, 5);
+	for(uint8_t i = 0; i < sizeof(input5) / sizeof(input5[0]); i++)
+	CHECK_EQ(Filter_Process(&chain, input5[i]), 500);
+	
+	// invalid windows are limited to 3 or 5
+	initStage(&chain, FILTER_MEDIAN, 4);
+	CHECK_EQ(chain.stage[0].param, 3);
+	initStage(&chain, FILTER_MEDIAN, 9);
+	CHECK_EQ(chain.stage[0].param, 5);
+}
+
+/**
+*
+* @brief Chain of median and IIR (default configuration of ioconfig.h)
+*
+* @return void
+*/
+static void testChain(void)
+{
+	const FilterConfig config[FILTER_MAX_STAGES] = { {FILTER_MEDIAN, 3}, {FILTER_IIR, 2}, {FILTER_NONE, 0} };
+	FilterChain chain;
+	
+	Filter_Init(&chain, config);
+	CHECK_EQ(chain.count, 2);
+	
+	// a single spike does not reach the IIR stage
+	for(uint8_t i = 0; i < 10; i++)
+	CHECK_EQ(Filter_Process(&chain, (i == 5) ? 1023 : 300), 300);
+	
+	// after a reset the next value initializes all stages
+	Filter_Reset(&chain);
+	CHECK_EQ(Filter_Process(&chain, 700), 700);
+}
+
+/**
+*
+* @brief Read the values of a trace as raw ADC values
+*
+* @param path trace file ("ms,value" per line)
+* @param values output of the values
+*
+* @return count of values
+*/
+static uint16_t loadTrace(const char *path, uint16_t *values)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+	unsigned long time;
+	double value;
+	uint16_t count = 0;
+	
+	CHECK(file != NULL);
+	
+	while(count < TRACE_MAX && fgets(line, sizeof(line), file))
+	{
+		if(sscanf(line, "%lu,%lf", &time, &value) != 2)
+		continue;
+		
+		values[count++] = (uint16_t)(value + 0.5);
+	}
+	
+	fclose(file);
+	
+	return count;
+}
+
+/**
+*
+* @brief Time per sample of every filter type on the host
+*
+* The output of every chain stays within the range of the trace.
+*
+* @return void
+*/
+static void benchFilters(void)
+{
+	static const struct{
+		const char *name;
+		FilterConfig config[FILTER_MAX_STAGES];
+	}bench[] = {
+		{ "moving average 8", { {FILTER_MOVING_AVERAGE, 3}, {FILTER_NONE, 0}, {FILTER_NONE, 0} } },
+		{ "IIR 1/4", { {FILTER_IIR, 2}, {FILTER_NONE, 0}, {FILTER_NONE, 0} } },
+		{ "median 3", { {FILTER_MEDIAN, 3}, {FILTER_NONE, 0}, {FILTER_NONE, 0} } },
+		{ "median 5", { {FILTER_MEDIAN, 5}, {FILTER_NONE, 0}, {FILTER_NONE, 0} } },
+		{ "median 3 + IIR 1/4", { {FILTER_MEDIAN, 3}, {FILTER_IIR, 2}, {FILTER_NONE, 0} } },
+	};
+	static uint16_t values[TRACE_MAX];
+	uint16_t min = 0xFFFF, max = 0;
+	FilterChain chain;
+	
+	uint16_t count = loadTrace(TRACE_FILE, values);
+	CHECK(count > 0);
+	
+	for(uint16_t i = 0; i < count; i++)
+	{
+		if(values[i] < min) min = values[i];
+		if(values[i] > max) max = values[i];
+	}
+	
+	for(uint8_t b = 0; b < sizeof(bench) / sizeof(bench[0]); b++)
+	{
+		volatile uint16_t out = 0;
+		
+		Filter_Init(&chain, bench[b].config);
+		for(uint16_t i = 0; i < count; i++)
+		{
+			out = Filter_Process(&chain, values[i]);
+			CHECK(out >= min && out <= max);
+		}
+		
+		clock_t start = clock();
+		for(uint16_t run = 0; run < BENCH_RUNS; run++)
+		{
+			for(uint16_t i = 0; i < count; i++)
+			out = Filter_Process(&chain, values[i]);
+		}
+		double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+		
+		printf("  %s: %.1f ns/sample on the host\n", bench[b].name, seconds * 1e9 / ((double)BENCH_RUNS * count));
+	}
+}
+
+int main(void)
+{
+	testMovingAverage();
+	testIIR();
+	testMedian();
+	testChain();
+	benchFilters();
+	
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,134 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_mqtt.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the MQTT 3.1.1 packets
+ *
+ * The packets are compared byte by byte with the layout of the specification.
+*/
+
+#include "test.h"
+#include "../libs/mqtt/mqtt.h"
+#include <string.h>
+
+/**
+*
+* @brief CONNECT with clean session and keep alive
+*
+* @return void
+*/
+static void testConnect(void)
+{
+	static const uint8_t expected[] = {
+		0x10, 24,							// CONNECT, remaining length
+		0x00, 0x04, 'M', 'Q', 'T', 'T',		// protocol name
+		0x04,								// protocol level 3.1.1
+		0x02,								// clean session
+		0x00, 120,							// keep alive
+		0x00, 12, 'd', 'a', 't', 'a', 'l', 'o', 'g', 'g', 'e', 'r', '-', '1'
+	};
+	uint8_t buffer[64];
+	
+	CHECK_EQ(MQTT_Connect(buffer, sizeof(buffer), "datalogger-1", 120), sizeof(expected));
+	CHECK(memcmp(buffer, expected, sizeof(expected)) == 0);
+	
+	// the packet has to fit completely
+	CHECK_EQ(MQTT_Connect(buffer, sizeof(expected), "datalogger-1", 120), sizeof(expected));
+	CHECK_EQ(MQTT_Connect(buffer, sizeof(expected) - 1, "datalogger-1", 120), 0);
+}
+
+/**
+*
+* @brief PUBLISH with QoS 0 and the lengths of the fixed header
+*
+* @return void
+*/
+static void testPublish(void)
+{
+	static const uint8_t expected[] = {0x30, 12, 0x00, 0x05, 'd', 'l', '/', 'c', 'h', '1', '2', '.', '5', '0'};
+	static uint8_t buffer[20000];
+	static char payload[17000];
+	
+	CHECK_EQ(MQTT_Publish(buffer, sizeof(buffer), "dl/ch", "12.50", 5), sizeof(expected));
+	CHECK(memcmp(buffer, expected, sizeof(expected)) == 0);
+	
+	CHECK_EQ(MQTT_Publish(buffer, sizeof(expected) - 1, "dl/ch", "12.50", 5), 0);
+	
+	memset(payload, 'x', sizeof(payload));
+	
+	// remaining length 127: one byte, 128: two bytes (0x80 0x01)
+	CHECK_EQ(MQTT_Publish(buffer, sizeof(buffer), "t", payload, 124), 2 + 127);
+	CHECK_EQ(buffer[1], 127);
+	CHECK_EQ(MQTT_Publish(buffer, sizeof(buffer), "t", payload, 125), 3 + 128);
+	CHECK_EQ(buffer[1], 0x80);
+	CHECK_EQ(buffer[2], 0x01);
+	CHECK_EQ(buffer[3], 0x00);
+	CHECK_EQ(buffer[4], 0x01);
+	CHECK_EQ(buffer[5], 't');
+	
+	// remaining length 16384: three bytes (0x80 0x80 0x01), the size check includes them
+	CHECK_EQ(MQTT_Publish(buffer, sizeof(buffer), "t", payload, 16381), 4 + 16384);
+	CHECK_EQ(buffer[1], 0x80);
+	CHECK_EQ(buffer[2], 0x80);
+	CHECK_EQ(buffer[3], 0x01);
+	CHECK_EQ(MQTT_Publish(buffer, 4 + 16383, "t", payload, 16381), 0);
+}
+
+/**
+*
+* @brief PINGREQ and the answers of the broker
+*
+* @return void
+*/
+static void testPing(void)
+{
+	static const uint8_t accepted[] = {0x20, 0x02, 0x00, 0x00};
+	static const uint8_t refused[] = {0x20, 0x02, 0x00, 0x05};
+	static const uint8_t pingResp[] = {0xD0, 0x00};
+	static const uint8_t publish[] = {0x30, 0x02, 0x00, 0x00};
+	uint8_t buffer[MQTT_PINGREQ_SIZE];
+	
+	CHECK_EQ(MQTT_PingReq(buffer, sizeof(buffer)), MQTT_PINGREQ_SIZE);
+	CHECK_EQ(buffer[0], 0xC0);
+	CHECK_EQ(buffer[1], 0x00);
+	CHECK_EQ(MQTT_PingReq(buffer, 1), 0);
+	
+	CHECK_EQ(MQTT_CheckAnswer(accepted, sizeof(accepted)), MQTT_ANSWER_OK);
+	CHECK_EQ(MQTT_CheckAnswer(refused, sizeof(refused)), MQTT_ANSWER_REFUSED);
+	CHECK_EQ(MQTT_CheckAnswer(pingResp, sizeof(pingResp)), MQTT_ANSWER_OK);
+	CHECK_EQ(MQTT_CheckAnswer(accepted, 3), MQTT_ANSWER_INVALID);
+	CHECK_EQ(MQTT_CheckAnswer(pingResp, 1), MQTT_ANSWER_INVALID);
+	CHECK_EQ(MQTT_CheckAnswer(publish, sizeof(publish)), MQTT_ANSWER_INVALID);
+}
+
+int main(void)
+{
+	testConnect();
+	testPublish();
+	testPing();
+	
+	puts("ok");
+	return 0;
+}
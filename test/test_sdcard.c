@@ -0,0 +1,348 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_sdcard.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the SDcard driver on a simulated card (stub/sdimage.c)
+ *
+ * libs/sdcard/sdcard.c talks SPI to an image file. Besides the checks, the bytes on
+ * the bus of single and multiple block writes (CMD24, ACMD23 + CMD25) and reads
+ * (CMD17, CMD18) are compared. The busy time is the model of sdimage.c, not a measurement: the
+ * reported times are SPI bytes at F_CPU/16 (spi.c), without the CPU time between them.
+*/
+
+#include "test.h"
+#include "stub/sdimage.h"
+#include "../libs/sdcard/sdcard.h"
+#include "../libs/sdcard/definitions.h"
+
+#define IMAGE_SECTORS	4096	/**< 2MB image					*/
+#define BENCH_BLOCKS	64		/**< blocks of the benchmark	*/
+
+/**
+*
+* @brief Fill _SDBuffer with a pattern of a sector
+*
+* @param sector sector number
+*
+* @return void
+*/
+static void pattern(uint32_t sector)
+{
+	for(uint16_t i = 0; i < 512; i++)
+	_SDBuffer[i] = (uint8_t)(sector * 7 + i);
+}
+
+/**
+*
+* @brief Compare a sector of the image with its pattern
+*
+* @param sector sector number
+*
+* @return true: content is the pattern
+*/
+static bool hasPattern(uint32_t sector)
+{
+	uint8_t data[512];
+	
+	SDImage_Read(sector, data);
+	for(uint16_t i = 0; i < 512; i++)
+	{
+		if(data[i] != (uint8_t)(sector * 7 + i))
+		return false;
+	}
+	
+	return true;
+}
+
+/**
+*
+* @brief Initialization, single block write and read
+*
+* @return void
+*/
+static void testSingleBlock(void)
+{
+	uint8_t token;
+	
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	
+	pattern(100);
+	CHECK_EQ(SDWriteBlock(100, &token), SD_READY);
+	CHECK_EQ(token, SD_DATA_ACCEPTED);
+	CHECK(hasPattern(100));
+	
+	memset((uint8_t *)_SDBuffer, 0, 512);
+	CHECK_EQ(SDReadBlock(100, &token), SD_READY);
+	CHECK_EQ(token, SD_START_TOKEN);
+	for(uint16_t i = 0; i < 512; i++)
+	CHECK_EQ(_SDBuffer[i], (uint8_t)(100 * 7 + i));
+	
+	// rejected block and a sector behind the end of the card
+	SDImage_FailWrite(101);
+	pattern(101);
+	CHECK_EQ(SDWriteBlock(101, &token), SD_READY);
+	CHECK(token != SD_DATA_ACCEPTED);
+	CHECK(!hasPattern(101));
+	CHECK(SDWriteBlock(IMAGE_SECTORS, &token) != SD_READY);
+	CHECK(SDReadBlock(IMAGE_SECTORS, &token) != SD_READY);
+}
+
+/**
+*
+* @brief Multiple block write with pre-erase, also with a rejected block
+*
+* @return void
+*/
+static void testMultiBlock(void)
+{
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	SDImage_ResetStats();
+	
+	CHECK_EQ(SDWriteMultiStart(200, 8), SD_READY);
+	for(uint32_t n = 0; n < 8; n++)
+	{
+		pattern(200 + n);
+		CHECK_EQ(SDWriteMultiBlock(), SD_DATA_ACCEPTED);
+	}
+	CHECK_EQ(SDWriteMultiStop(), SD_SUCCESS);
+	
+	for(uint32_t n = 0; n < 8; n++)
+	CHECK(hasPattern(200 + n));
+	CHECK_EQ(SDImage_Stats()->eraseCounts, 1);
+	CHECK_EQ(SDImage_Stats()->blocksWritten, 8);
+	
+	// without pre-erase, the third block is rejected and the write is stopped
+	SDImage_FailWrite(302);
+	CHECK_EQ(SDWriteMultiStart(300, 0), SD_READY);
+	for(uint32_t n = 0; n < 3; n++)
+	{
+		pattern(300 + n);
+		CHECK_EQ(SDWriteMultiBlock() == SD_DATA_ACCEPTED, n < 2);
+	}
+	CHECK_EQ(SDWriteMultiStop(), SD_SUCCESS);
+	CHECK_EQ(SDImage_Stats()->eraseCounts, 1);
+	CHECK(hasPattern(300) && hasPattern(301) && !hasPattern(302));
+	
+	// the card accepts commands again
+	uint8_t token;
+	CHECK_EQ(SDReadBlock(300, &token), SD_READY);
+	CHECK_EQ(token, SD_START_TOKEN);
+}
+
+static uint32_t readCount;		/**< blocks handed to readBlock()		*/
+static uint32_t readStop;		/**< index at which readBlock() stops	*/
+
+/**
+*
+* @brief Check a block of the multiple block read (SDReadBlocks callback)
+*
+* @param index index of the block in the read
+*
+* @return 0: continue | 1: stop the read
+*/
+static uint8_t readBlock(uint32_t index)
+{
+	CHECK_EQ(index, readCount);
+	for(uint16_t i = 0; i < 512; i++)
+	CHECK_EQ(_SDBuffer[i], (uint8_t)((500 + index) * 7 + i));
+	
+	readCount++;
+	
+	return index == readStop;
+}
+
+/**
+*
+* @brief Count a block of the multiple block read (SDReadBlocks callback)
+*
+* @param index index of the block in the read
+*
+* @return 0: continue
+*/
+static uint8_t readAny(uint32_t index)
+{
+	CHECK_EQ(index, readCount);
+	readCount++;
+	
+	return 0;
+}
+
+/**
+*
+* @brief Multiple block read, complete and stopped by the callback
+*
+* @return void
+*/
+static void testReadBlocks(void)
+{
+	uint8_t token;
+	
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	
+	for(uint32_t n = 0; n < 10; n++)
+	{
+		pattern(500 + n);
+		SDImage_Write(500 + n, (uint8_t *)_SDBuffer);
+	}
+	
+	SDImage_ResetStats();
+	readCount = 0;
+	readStop = 0xFFFFFFFF;
+	CHECK_EQ(SDReadBlocks(500, 10, &token, &readBlock), SD_READY);
+	CHECK_EQ(token, SD_START_TOKEN);
+	CHECK_EQ(readCount, 10);
+	CHECK_EQ(SDImage_Stats()->commands, 2);
+	
+	// the callback ends the read, CMD12 stops the card within the next block
+	readCount = 0;
+	readStop = 3;
+	CHECK_EQ(SDReadBlocks(500, 10, &token, &readBlock), SD_READY);
+	CHECK_EQ(token, SD_START_TOKEN);
+	CHECK_EQ(readCount, 4);
+	
+	// the card accepts commands again, a read behind the end is rejected
+	CHECK_EQ(SDReadBlock(509, &token), SD_READY);
+	CHECK_EQ(token, SD_START_TOKEN);
+	CHECK_EQ(_SDBuffer[0], (uint8_t)(509 * 7));
+	
+	readCount = 0;
+	CHECK(SDReadBlocks(IMAGE_SECTORS, 2, &token, &readBlock) != SD_READY);
+	CHECK(token != SD_START_TOKEN);
+	CHECK_EQ(readCount, 0);
+}
+
+/**
+*
+* @brief Read BENCH_BLOCKS blocks with CMD17 and with CMD18 and print the bus load
+*
+* @return void
+*/
+static void benchRead(void)
+{
+	uint8_t token;
+	uint64_t single;
+	double byteTime = 8.0 * 16 / F_CPU;
+	
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	
+	SDImage_ResetStats();
+	for(uint32_t n = 0; n < BENCH_BLOCKS; n++)
+	CHECK_EQ(SDReadBlock(n, &token), SD_READY);
+	single = SDImage_Stats()->bytes;
+	
+	SDImage_ResetStats();
+	readCount = 0;
+	readStop = 0xFFFFFFFF;
+	CHECK_EQ(SDReadBlocks(500, BENCH_BLOCKS, &token, &readAny), SD_READY);
+	CHECK_EQ(readCount, BENCH_BLOCKS);
+	
+	printf("  CMD17: %llu SPI bytes, %.1f ms\n", (unsigned long long)single, single * byteTime * 1000);
+	printf("  CMD18: %llu SPI bytes, %.1f ms\n", (unsigned long long)SDImage_Stats()->bytes, SDImage_Stats()->bytes * byteTime * 1000);
+	
+	CHECK(SDImage_Stats()->bytes < single);
+}
+
+/**
+*
+* @brief Write BENCH_BLOCKS blocks and print the bus load
+*
+* @param multi true: ACMD23 + CMD25 | false: CMD24 per block
+*
+* @return SPI bytes of the write (including the busy time)
+*/
+static uint64_t bench(bool multi)
+{
+	uint8_t token;
+	
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	CHECK_EQ(SDInit(), SD_SUCCESS);
+	SDImage_ResetStats();
+	
+	if(multi)
+	{
+		CHECK_EQ(SDWriteMultiStart(1000, BENCH_BLOCKS), SD_READY);
+		for(uint32_t n = 0; n < BENCH_BLOCKS; n++)
+		{
+			pattern(1000 + n);
+			CHECK_EQ(SDWriteMultiBlock(), SD_DATA_ACCEPTED);
+		}
+		CHECK_EQ(SDWriteMultiStop(), SD_SUCCESS);
+	}
+	else
+	{
+		for(uint32_t n = 0; n < BENCH_BLOCKS; n++)
+		{
+			pattern(1000 + n);
+			CHECK_EQ(SDWriteBlock(1000 + n, &token), SD_READY);
+			CHECK_EQ(token, SD_DATA_ACCEPTED);
+		}
+	}
+	
+	for(uint32_t n = 0; n < BENCH_BLOCKS; n++)
+	CHECK(hasPattern(1000 + n));
+	
+	const SDImageStats *stats = SDImage_Stats();
+	double byteTime = 8.0 * 16 / F_CPU;
+	double seconds = stats->bytes * byteTime;
+	
+	printf("  %s: %llu SPI bytes, %llu busy (%.1f ms), %.1f ms, %.1f kB/s\n",
+		multi ? "CMD25" : "CMD24", (unsigned long long)stats->bytes, (unsigned long long)stats->busyBytes,
+		stats->busyBytes * byteTime * 1000, seconds * 1000, BENCH_BLOCKS * 0.512 / seconds);
+	
+	return stats->bytes;
+}
+
+/**
+*
+* @brief A multiple block write needs less bus time than single block writes
+*
+* @return void
+*/
+static void testBenchmark(void)
+{
+	uint64_t single = bench(false);
+	uint64_t multi = bench(true);
+	
+	CHECK(multi < single);
+	
+	benchRead();
+}
+
+int main(void)
+{
+	testSingleBlock();
+	testMultiBlock();
+	testReadBlocks();
+	testBenchmark();
+	
+	SDImage_Close();
+	
+	puts("ok");
+	return 0;
+}
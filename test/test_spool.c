@@ -0,0 +1,345 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_spool.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the store-and-forward spool
+ *
+ * The spool file lies on a FAT32 image of the simulated SDcard. The module is included,
+ * so a power-up can be simulated by clearing its power-up counter.
+*/
+
+#include "test.h"
+#include "fatimage.h"
+#include "stub/sdimage.h"
+#include "../routines/spoolRoutine.c"
+
+#define IMAGE_SECTORS	2048					/**< 1MB image							*/
+#define CAPACITY		(2 * SPOOL_PER_SECTOR)	/**< spool file of 3 sectors			*/
+
+static uint32_t millis = 0;						/**< simulated timebase					*/
+static uint32_t secondsLeft = 60;				/**< simulated time to the next send slot	*/
+
+uint32_t Timebase_Millis(void)
+{
+	return millis;
+}
+
+uint32_t runSecondsLeft(void)
+{
+	return secondsLeft;
+}
+
+/**
+*
+* @brief Format the image and add the spool file
+*
+* @param sectors size of the spool file in sectors
+*
+* @return first cluster of the file
+*/
+static uint32_t setup(uint32_t sectors)
+{
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	FatImage_Format(IMAGE_SECTORS, 1);
+	
+	return FatImage_AddFile("SPOOL   BIN", sectors * 512);
+}
+
+/**
+*
+* @brief Open the spool after a reset
+*
+* @return result of spoolInit()
+*/
+static bool powerUp(void)
+{
+	boot = 0;
+	millis = 0;
+	
+	return spoolInit(false);
+}
+
+/**
+*
+* @brief Store a sample with the values n...n+3
+*
+* @param n sample number
+* @param seconds time of the sample
+*
+* @return result of spoolPush()
+*/
+static bool push(uint16_t n, uint32_t seconds)
+{
+	uint16_t values[ADC_SCAN_MAX_CHANNELS];
+	
+	for(uint8_t i = 0; i < ADC_SCAN_MAX_CHANNELS; i++)
+	values[i] = n + i;
+	
+	return spoolPush(values, seconds);
+}
+
+/**
+*
+* @brief Check a sample of the spool
+*
+* @param index position in the spool
+* @param n expected sample number
+* @param seconds expected time
+*
+* @return void
+*/
+static void checkPeek(uint32_t index, uint16_t n, uint32_t seconds)
+{
+	uint16_t values[ADC_SCAN_MAX_CHANNELS];
+	uint32_t time;
+	
+	CHECK(spoolPeek(index, values, &time));
+	CHECK_EQ(time, seconds);
+	for(uint8_t i = 0; i < ADC_SCAN_MAX_CHANNELS; i++)
+	CHECK_EQ(values[i], n + i);
+}
+
+/**
+*
+* @brief FIFO order and removal
+*
+* @return void
+*/
+static void testOrder(void)
+{
+	uint16_t values[ADC_SCAN_MAX_CHANNELS];
+	uint32_t time;
+	
+	setup(3);
+	CHECK(powerUp());
+	CHECK_EQ(capacity, CAPACITY);
+	CHECK_EQ(spoolCount(), 0);
+	CHECK(!spoolPeek(0, values, &time));
+	
+	for(uint16_t n = 0; n < 5; n++)
+	CHECK(push(n, 100 + n));
+	
+	CHECK_EQ(spoolCount(), 5);
+	for(uint16_t n = 0; n < 5; n++)
+	checkPeek(n, n, 100 + n);
+	CHECK(!spoolPeek(5, values, &time));
+	
+	spoolPop();
+	spoolPop();
+	spoolCommit();
+	CHECK_EQ(spoolCount(), 3);
+	checkPeek(0, 2, 102);
+	
+	// removing from an empty spool does nothing
+	for(uint8_t n = 0; n < 5; n++)
+	spoolPop();
+	CHECK_EQ(spoolCount(), 0);
+}
+
+/**
+*
+* @brief A full spool overwrites the oldest samples, also across the sectors
+*
+* @return void
+*/
+static void testWrap(void)
+{
+	setup(3);
+	CHECK(powerUp());
+	
+	for(uint16_t n = 0; n < CAPACITY + 10; n++)
+	CHECK(push(n, n));
+	
+	CHECK_EQ(spoolCount(), CAPACITY);
+	checkPeek(0, 10, 10);
+	checkPeek(SPOOL_PER_SECTOR - 1, SPOOL_PER_SECTOR + 9, SPOOL_PER_SECTOR + 9);
+	checkPeek(CAPACITY - 1, CAPACITY + 9, CAPACITY + 9);
+	
+	// drain and refill through the end of the file
+	for(uint16_t n = 0; n < CAPACITY - 1; n++)
+	{
+		checkPeek(0, n + 10, n + 10);
+		spoolPop();
+	}
+	spoolCommit();
+	CHECK(push(1000, 1000));
+	CHECK_EQ(spoolCount(), 2);
+	checkPeek(0, CAPACITY + 9, CAPACITY + 9);
+	checkPeek(1, 1000, 1000);
+}
+
+/**
+*
+* @brief The header keeps the spool over a restart, removals count after spoolCommit()
+*
+* @return void
+*/
+static void testReopen(void)
+{
+	setup(3);
+	CHECK(powerUp());
+	
+	for(uint16_t n = 0; n < 5; n++)
+	CHECK(push(n, 10 * n));
+	
+	// a restart of the logger within the power-up repeats the not committed samples
+	spoolPop();
+	spoolPop();
+	CHECK(spoolInit(false));
+	CHECK_EQ(spoolCount(), 5);
+	checkPeek(0, 0, 0);
+	
+	spoolPop();
+	spoolPop();
+	spoolCommit();
+	CHECK(spoolInit(false));
+	CHECK_EQ(spoolCount(), 3);
+	checkPeek(0, 2, 20);
+	checkPeek(2, 4, 40);
+}
+
+/**
+*
+* @brief Samples of an earlier power-up are dated to the reset
+*
+* @return void
+*/
+static void testPowerUp(void)
+{
+	uint32_t first = setup(3);
+	uint8_t header[512];
+	
+	CHECK(powerUp());
+	CHECK(push(0, 50));
+	CHECK(push(1, 60));
+	
+	CHECK(powerUp());
+	CHECK(push(2, 7));
+	CHECK_EQ(spoolCount(), 3);
+	checkPeek(0, 0, 0);
+	checkPeek(1, 1, 0);
+	checkPeek(2, 2, 7);
+	
+	// the header counts the power-ups
+	SDImage_Read(FatImage_FirstSector(first), header);
+	CHECK_EQ(header[16] | header[17] << 8, 2);
+	CHECK(powerUp());
+	SDImage_Read(FatImage_FirstSector(first), header);
+	CHECK_EQ(header[16] | header[17] << 8, 3);
+}
+
+/**
+*
+* @brief Missing, short and fragmented files and a write error disable the spool
+*
+* @return void
+*/
+static void testUnavailable(void)
+{
+	setup(0);
+	CHECK(SDImage_Open(NULL, IMAGE_SECTORS));
+	FatImage_Format(IMAGE_SECTORS, 1);
+	CHECK(!powerUp());
+	CHECK(!push(0, 0));
+	CHECK_EQ(spoolCount(), 0);
+	
+	setup(1);
+	CHECK(!powerUp());
+	
+	// the second cluster is not the following one
+	uint32_t first = setup(3);
+	FatImage_AddFile("OTHER   TXT", 512);
+	FatImage_SetEntry(first, first + 3);
+	FatImage_SetEntry(first + 3, first + 1);
+	CHECK(!powerUp());
+	
+	// a rejected write disables the spool until the next spoolInit()
+	first = setup(3);
+	CHECK(powerUp());
+	CHECK(push(0, 0));
+	SDImage_FailWrite(FatImage_FirstSector(first) + 1);
+	CHECK(!push(1, 1));
+	CHECK_EQ(spoolCount(), 0);
+	CHECK(!push(2, 2));
+	CHECK(spoolInit(false));
+	CHECK_EQ(spoolCount(), 1);
+}
+
+/**
+*
+* @brief Drain only after a successful transmission, the drain period and with time left
+*
+* @return void
+*/
+static void testDrainDue(void)
+{
+	setup(3);
+	CHECK(powerUp());
+	CHECK(push(0, 0));
+	CHECK(!spoolDrainDue());
+	
+	CHECK(spoolInit(true));
+	secondsLeft = 60;
+	millis = SPOOL_DRAIN_PERIOD - 1;
+	CHECK(!spoolDrainDue());
+	millis = SPOOL_DRAIN_PERIOD;
+	CHECK(spoolDrainDue());
+	
+	secondsLeft = SPOOL_DRAIN_MARGIN;
+	CHECK(!spoolDrainDue());
+	secondsLeft = SPOOL_DRAIN_MARGIN + 1;
+	CHECK(spoolDrainDue());
+	
+	spoolOnline(false);
+	CHECK(!spoolDrainDue());
+	spoolOnline(true);
+	CHECK(spoolDrainDue());
+	
+	// the drain period starts again
+	spoolCommit();
+	CHECK(!spoolDrainDue());
+	millis += SPOOL_DRAIN_PERIOD;
+	CHECK(spoolDrainDue());
+	
+	spoolPop();
+	spoolCommit();
+	millis += SPOOL_DRAIN_PERIOD;
+	CHECK(!spoolDrainDue());
+}
+
+int main(void)
+{
+	testOrder();
+	testWrap();
+	testReopen();
+	testPowerUp();
+	testUnavailable();
+	testDrainDue();
+	
+	SDImage_Close();
+	
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,213 @@
+/**
+* Copyright 2019 Jean-Marcel Herzog
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+* associated documentation files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense
+* and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do
+* so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all copies or
+* substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+* PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+* COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+* AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+* WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+/**
+ * @author: Herzog, Jean-Marcel
+ * @file test_statistics.c
+ * @copyright Copyright 2019 Jean-Marcel Herzog. This project is released under the MIT license.
+ * @date 25.11.2019
+ * @version 1
+ *
+ * @brief Host test of the running statistics
+ *
+ * The results are compared with a double precision reference (sample standard
+ * deviation, mean rounded half up).
+*/
+
+#include "test.h"
+#include "../libs/statistics/statistics.h"
+#include <math.h>
+
+/**
+*
+* @brief Compare the statistics of a sample set with the reference
+*
+* @param values samples
+* @param count count of samples
+*
+* @return void
+*/
+static void checkReference(const uint16_t *values, uint32_t count)
+{
+	StatAccumulator acc;
+	StatResult result;
+	double sum = 0, squares = 0;
+	uint16_t min = 0xFFFF, max = 0;
+	
+	Stat_Reset(&acc);
+	for(uint32_t i = 0; i < count; i++)
+	{
+		Stat_Add(&acc, values[i]);
+		sum += values[i];
+		if(values[i] < min) min = values[i];
+		if(values[i] > max) max = values[i];
+	}
+	
+	double mean = sum / count;
+	for(uint32_t i = 0; i < count; i++)
+	squares += (values[i] - mean) * (values[i] - mean);
+	
+	Stat_Result(&acc, &result);
+	
+	CHECK_EQ(result.count, count);
+	CHECK_EQ(result.min, min);
+	CHECK_EQ(result.max, max);
+	CHECK(fabs(result.mean - floor(mean + 0.5)) <= 1);
+	CHECK(fabs(result.stddev - sqrt(squares / (count - 1))) <= 1);
+}
+
+/**
+*
+* @brief Empty interval, single value and a textbook sample set
+*
+* @return void
+*/
+static void testBasic(void)
+{
+	static const uint16_t values[] = {2, 4, 4, 4, 5, 5, 7, 9};
+	StatAccumulator acc;
+	StatResult result;
+	
+	Stat_Reset(&acc);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.count, 0);
+	CHECK_EQ(result.min, 0);
+	CHECK_EQ(result.max, 0);
+	CHECK_EQ(result.mean, 0);
+	CHECK_EQ(result.stddev, 0);
+	
+	Stat_Add(&acc, 0xFFFF);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.mean, 0xFFFF);
+	CHECK_EQ(result.stddev, 0);
+	
+	// mean 5, sample variance 32 / 7
+	Stat_Reset(&acc);
+	for(uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+	Stat_Add(&acc, values[i]);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.min, 2);
+	CHECK_EQ(result.max, 9);
+	CHECK_EQ(result.mean, 5);
+	CHECK_EQ(result.stddev, 2);
+}
+
+/**
+*
+* @brief Negative deltas to the first value and rounding of the mean
+*
+* @return void
+*/
+static void testNegative(void)
+{
+	StatAccumulator acc;
+	StatResult result;
+	
+	// 999.5 is rounded up, although the shifted sum is negative
+	Stat_Reset(&acc);
+	Stat_Add(&acc, 1000);
+	Stat_Add(&acc, 999);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.mean, 1000);
+	
+	// 998.25 -> 998
+	Stat_Add(&acc, 997);
+	Stat_Add(&acc, 997);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.mean, 998);
+	
+	// the first value is the max: all deltas are negative
+	static const uint16_t falling[] = {0xFFFF, 0, 1, 0x8000, 0xFFFE, 0};
+	checkReference(falling, sizeof(falling) / sizeof(falling[0]));
+}
+
+/**
+*
+* @brief Full scale values: the sums need the 64 bit path
+*
+* @return void
+*/
+static void testFullScale(void)
+{
+	static uint16_t values[100000];
+	StatAccumulator acc;
+	StatResult result;
+	
+	// alternating 0 and 0xFFFF, starting with both extremes
+	for(uint32_t i = 0; i < 100000; i++)
+	values[i] = (i & 1) ? 0xFFFF : 0;
+	checkReference(values, 100000);
+	
+	for(uint32_t i = 0; i < 100000; i++)
+	values[i] = (i & 1) ? 0 : 0xFFFF;
+	checkReference(values, 100000);
+	
+	// 10^7 samples (14 h at 200 Hz): sum * mean exceeds 2^48
+	Stat_Reset(&acc);
+	for(uint32_t i = 0; i < 10000000; i++)
+	Stat_Add(&acc, (i & 1) ? 0xFFFF : 0);
+	Stat_Result(&acc, &result);
+	CHECK_EQ(result.count, 10000000);
+	CHECK_EQ(result.mean, 32768);
+	CHECK(result.stddev >= 32767 && result.stddev <= 32768);
+	
+	// the count saturates instead of wrapping
+	acc.count = 0xFFFFFFFF;
+	Stat_Add(&acc, 0);
+	CHECK_EQ(acc.count, 0xFFFFFFFF);
+}
+
+/**
+*
+* @brief Random noise around random offsets
+*
+* @return void
+*/
+static void testRandom(void)
+{
+	static uint16_t values[5000];
+	uint32_t seed = 4711;
+	
+	for(uint8_t run = 0; run < 50; run++)
+	{
+		seed = seed * 1103515245 + 12345;
+		uint16_t offset = (uint16_t)(seed >> 12);
+		uint16_t noise = (run & 1) ? 0xFFFF : 64;
+		
+		for(uint16_t i = 0; i < 5000; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			uint32_t value = offset + (seed >> 16) % noise;
+			values[i] = (value > 0xFFFF) ? 0xFFFF : (uint16_t)value;
+		}
+		
+		checkReference(values, 5000);
+	}
+}
+
+int main(void)
+{
+	testBasic();
+	testNegative();
+	testFullScale();
+	testRandom();
+	
+	puts("ok");
+	return 0;
+}
@@ -42,6 +42,7 @@
 #include "../libs/lcd/lcd_lib.h"
 #include "../libs/uart/uart.h"
 #include "../libs/delay/delay.h"
+#include "../libs/scheduler/scheduler.h"
 
 /**
 *
@@ -63,6 +64,8 @@ uint8_t chooseSourceView()
 	lcd_putstr("[ ] Hostname");
 	
 	do{
+		Scheduler_Yield();	// background tasks
+		
 		GPIO_PrepareAsInput();
 		selectionChanged = 0;
 		
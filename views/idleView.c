@@ -36,6 +36,7 @@
 #include "../ioconfig.h"
 #include "../libs/gpio/gpio.h"
 #include "../libs/lcd/lcd_lib.h"
+#include "../libs/scheduler/scheduler.h"
 
 /**
 *
@@ -60,6 +61,8 @@ bool idleView()
 	// read buttons
 	while(1)
 	{
+		Scheduler_Yield();	// background tasks
+		
 		// EXIT button pressed?
 		if(GPIO_GetSwitchState(4))
 		{
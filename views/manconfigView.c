@@ -51,6 +51,7 @@
 #include "../libs/lcd/lcd_lib.h"
 #include "../libs/uart/uart.h"
 #include "../libs/delay/delay.h"
+#include "../libs/scheduler/scheduler.h"
 
 
 uint16_t delayCount;
@@ -101,6 +102,7 @@ void setupIPView(uint8_t *paramIPAddress, bool *pulseSwitch, bool *pulseRefresh)
 	bool sw4New = false;
 	
 	do{
+		Scheduler_Yield();	// background tasks
 		
 		//
 		// read button states
@@ -271,6 +273,8 @@ void setupFourCharacters(uint8_t *data, bool *pulseSwitch, bool *pulseRefresh)
 	
 	while(1)
 	{
+		Scheduler_Yield();	// background tasks
+		
 		if(*pulseRefresh)
 		{
 			GPIO_PrepareAsInput();
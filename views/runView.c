@@ -28,7 +28,7 @@
 * @brief Display view datalogger active
 *
 * This view show up the user that the datalogger is active.
-* A countdown display the user the time until next send.
+* A countdown display the user the time until next send slot.
 *
 * Tasterfunktion:
 *	Taster 4 - Datenlogger stoppen
@@ -39,6 +39,12 @@
 #include "../libs/lcd/lcd_lib.h"
 #include "../libs/adc/adc.h"
 #include "../libs/gpio/gpio.h"
+#include "../libs/scheduler/scheduler.h"
+#include "../routines/measureRoutine.h"
+#include "../routines/captureRoutine.h"
+#include "../routines/runRoutine.h"
+#include "../routines/spoolRoutine.h"
+#include "../ioconfig.h"
 
 /**
 *
@@ -48,12 +54,10 @@
 *
 * @param pulseRefresh button refresh pulse
 *
-* @param sec seconds until next send
-*
-* @return 0: send | 1: stop datalogger
+* @return 0: send | 1: stop datalogger | 2: captured burst ready | 3: drain the spool
 *
 */
-uint8_t runView(bool *pulseRefresh, bool *pulseSwitch, uint32_t *sec)
+uint8_t runView(bool *pulseRefresh, bool *pulseSwitch)
 {
 	lcd_clearDisplay();
 	lcd_gotoxy(0,0);
@@ -64,8 +68,22 @@ uint8_t runView(bool *pulseRefresh, bool *pulseSwitch, uint32_t *sec)
 
 	uint8_t sw1_state;
 	uint8_t pulse500cnt = 0;
-	while(*sec > 0)
+	while(!runDue())
 	{
+		// background tasks (sampling, network)
+		Scheduler_Yield();
+		
+		#ifdef MEASURE_CAPTURE
+		// upload a triggered capture immediately
+		if(captureAvailable())
+		return 2;
+		#endif
+		
+		#ifdef SD_SPOOL
+		// send spooled samples between the send slots
+		if(spoolDrainDue())
+		return 3;
+		#endif
 		
 		if(*pulseRefresh)
 		{
@@ -92,7 +110,7 @@ uint8_t runView(bool *pulseRefresh, bool *pulseSwitch, uint32_t *sec)
 			uint8_t tausend = 0;
 			uint8_t hundert = 0;
 			uint8_t zehner = 0;
-			uint32_t sec_copy = *sec;
+			uint32_t sec_copy = runSecondsLeft();
 			while(sec_copy >= 1000)
 			{
 				tausend++;
@@ -116,8 +134,6 @@ uint8_t runView(bool *pulseRefresh, bool *pulseSwitch, uint32_t *sec)
 			lcd_putc(zehner+48);
 			lcd_gotoxy(1,3);
 			lcd_putc(sec_copy+48);
-
-			*sec -= 1;
 		}
 
 		*pulseSwitch = false;
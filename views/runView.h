@@ -32,6 +32,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-uint8_t runView(bool *pulseRefresh, bool *pulseSwitch, uint32_t *sec);
+uint8_t runView(bool *pulseRefresh, bool *pulseSwitch);
 
 #endif /* RUNVIEW_H_ */
\ No newline at end of file
@@ -40,6 +40,7 @@
 #include "../ioconfig.h"
 #include "../libs/gpio/gpio.h"
 #include "../libs/lcd/lcd_lib.h"
+#include "../libs/scheduler/scheduler.h"
 
 #ifdef DEBUG_MODE
 #include "../libs/uart/uart.h"
@@ -74,6 +75,7 @@ uint8_t setupView(void)
 	bool selectionChanged = false;	// flag for selection changed -> view will be updated
 	
 	do{
+		Scheduler_Yield();	// background tasks
 		
 		GPIO_PrepareAsInput();
 		selectionChanged = 0;